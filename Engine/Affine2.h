@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Vec2.h"
+#include "Mat2.h"
+
+// 2D affine transform (2x3 matrix), p' = p * linear + translation
+// row vector convention like Mat2, a * b applies a first and then b
+template <typename T>
+class _Affine2
+{
+public:
+	_Affine2 operator*( const _Affine2& rhs ) const
+	{
+		return{ linear * rhs.linear,translation * rhs.linear + rhs.translation };
+	}
+	_Affine2& operator*=( const _Affine2& rhs )
+	{
+		return *this = *this * rhs;
+	}
+	static _Affine2 Identity()
+	{
+		return{ _Mat2<T>::Identity(),{ (T)0.0,(T)0.0 } };
+	}
+	// scales x and y independently and then translates
+	static _Affine2 ScaleTranslate( T sx,T sy,T tx,T ty )
+	{
+		return{ { sx,(T)0.0,(T)0.0,sy },{ tx,ty } };
+	}
+public:
+	_Mat2<T> linear;
+	_Vec2<T> translation;
+};
+
+template<typename T>
+_Vec2<T> operator*( const _Vec2<T>& lhs,const _Affine2<T>& rhs )
+{
+	return lhs * rhs.linear + rhs.translation;
+}
+
+typedef _Affine2<float> Affine2;
+typedef _Affine2<double> Affined2;
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "SolidEffect.h"
+
+// translucent solid color, composited over what is already drawn with the color's alpha
+// (255 opaque ~ 0 invisible), same vertices, transforms and instances as SolidEffect
+// draw it after the opaque geometry it should show, with a pipeline of its own
+// (no span occlusion or multisampling, see IsAlphaBlended)
+class AlphaEffect
+{
+public:
+	// 2D only, pipeline takes the affine path (see IsAffine2D)
+	static constexpr bool isAffine2D = true;
+	using Vertex = SolidEffect::Vertex;
+	using VertexShader = SolidEffect::VertexShader;
+	using GeometryShader = SolidEffect::GeometryShader;
+	class PixelShader : public SolidEffect::PixelShader
+	{
+	public:
+		// spans are blended over the render target instead of filled
+		static constexpr bool isBlended = true;
+	};
+	using Instance = SolidEffect::Instance;
+public:
+	bool IsInstanceVisible( const Instance& inst ) const
+	{
+		return vs.cam.Overlaps( inst.translation,inst.boundingRadius );
+	}
+	void BindInstance( const Instance& inst )
+	{
+		vs.BindRotation( inst.rotation );
+		vs.BindTranslation( inst.translation );
+		ps.BindColor( inst.color );
+	}
+public:
+	VertexShader vs;
+	GeometryShader gs;
+	PixelShader ps;
+};
\ No newline at end of file
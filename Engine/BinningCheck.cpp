@@ -0,0 +1,266 @@
+#include "MainWindow.h"
+#include "BinningCheck.h"
+#include <iostream>
+#include <string>
+#include <utility>
+
+BinningCheck::BinningCheck( MainWindow& wnd )
+	:
+	gfx( wnd )
+{}
+
+int BinningCheck::Run()
+{
+	int nFailed = 0;
+
+	// 2D effects: instances scattered over the screen and past its edges
+	std::vector<SolidEffect::Instance> solidInstances;
+	for( int i = 0; i < nInstances; i++ )
+	{
+		const float scale = Random( 0.1f,0.8f );
+		solidInstances.push_back( {
+			Mat2::Rotation( Random( 0.0f,2.0f * PI ) ) * Mat2::Scaling( scale ),
+			{ Random( -1.2f,1.2f ),Random( -1.2f,1.2f ) },
+			Color( (unsigned int)(rng()) ),
+			scale * 2.0f } );
+	}
+	const auto solidTriangles = MakeTriangles<SolidEffect::Vertex>( []( const Vec2& pos )
+	{
+		return pos;
+	} );
+	const IndexedTriangleList<SolidEffect::Vertex> box( { { -1.0f,-1.0f },{ 1.0f,-1.0f },{ 1.0f,1.0f },{ -1.0f,1.0f } },{ 0,1,2,0,2,3 } );
+	Pipeline<SolidEffect> solid( gfx );
+	nFailed += Compare( L"solid",solid,[&]()
+	{
+		solid.DrawInstanced( solidTriangles,solidInstances );
+	} );
+	nFailed += Compare( L"solid quads",solid,[&]()
+	{
+		solid.DrawInstancedQuads( box,solidInstances );
+	} );
+	solid.SetDepthTest( true );
+	nFailed += Compare( L"solid depth tested",solid,[&]()
+	{
+		solid.DrawInstanced( solidTriangles,solidInstances );
+	} );
+
+	// the random color alphas make them translucent
+	Pipeline<AlphaEffect> alpha( gfx );
+	nFailed += Compare( L"alpha",alpha,[&]()
+	{
+		alpha.DrawInstanced( solidTriangles,solidInstances );
+	} );
+	nFailed += CheckCoverage( alpha );
+
+	std::vector<GradientEffect::Instance> gradientInstances;
+	std::vector<TexturedEffect::Instance> texturedInstances;
+	for( const auto& inst : solidInstances )
+	{
+		gradientInstances.push_back( { inst.rotation,inst.translation,inst.boundingRadius } );
+		texturedInstances.push_back( { inst.rotation,inst.translation,inst.boundingRadius,&checker,inst.color,1.0f } );
+	}
+	const auto gradientTriangles = MakeTriangles<GradientEffect::Vertex>( [this]( const Vec2& pos )
+	{
+		return GradientEffect::Vertex{ pos,{ Random( 0.0f,255.0f ),Random( 0.0f,255.0f ),Random( 0.0f,255.0f ) } };
+	} );
+	Pipeline<GradientEffect> gradient( gfx );
+	nFailed += Compare( L"gradient",gradient,[&]()
+	{
+		gradient.DrawInstanced( gradientTriangles,gradientInstances );
+	} );
+	const auto texturedTriangles = MakeTriangles<TexturedEffect::Vertex>( [this]( const Vec2& pos )
+	{
+		return TexturedEffect::Vertex{ pos,{ Random( 0.0f,1.0f ),Random( 0.0f,1.0f ) } };
+	} );
+	Pipeline<TexturedEffect> textured( gfx );
+	nFailed += Compare( L"textured",textured,[&]()
+	{
+		textured.DrawInstanced( texturedTriangles,texturedInstances );
+	} );
+
+	// perspective, depth tested (and interpenetrating) triangles in front of the camera
+	std::vector<FlatShadeEffect::Instance> flatShadeInstances;
+	for( int i = 0; i < nInstances; i++ )
+	{
+		const Mat4 rotation = Mat4::RotationY( Random( 0.0f,2.0f * PI ) ) * Mat4::RotationX( Random( 0.0f,2.0f * PI ) );
+		const Vec3 position = { Random( -1.5f,1.5f ),Random( -1.5f,1.5f ),Random( 1.5f,3.0f ) };
+		flatShadeInstances.push_back( {
+			rotation * Mat4::Translation( position.x,position.y,position.z ),
+			Color( (unsigned int)(rng()) ) } );
+	}
+	const auto flatShadeTriangles = MakeTriangles<FlatShadeEffect::Vertex>( [this]( const Vec2& pos )
+	{
+		return FlatShadeEffect::Vertex{ { pos.x,pos.y,Random( -0.5f,0.5f ) } };
+	} );
+	Pipeline<FlatShadeEffect> flatShade( gfx );
+	flatShade.effect.vs.BindViewProjection( Mat4::ProjectionHFOV( PI / 2.0f,1.0f,0.1f,10.0f ) );
+	flatShade.SetDepthTest( true );
+	nFailed += Compare( L"flat shade",flatShade,[&]()
+	{
+		flatShade.DrawInstanced( flatShadeTriangles,flatShadeInstances );
+	} );
+
+	return nFailed;
+}
+
+template<class Effect,class Draw>
+int BinningCheck::Compare( const wchar_t* name,Pipeline<Effect>& pipeline,Draw draw )
+{
+	int nFailed = 0;
+	for( const auto& core : cores )
+	{
+		pipeline.SetRasterCore( core.first );
+		pipeline.SetRasterMode( RasterMode::Immediate );
+		const std::vector<Color> immediate = Render( pipeline,draw );
+		pipeline.SetRasterMode( RasterMode::Binned );
+		const std::vector<Color> binned = Render( pipeline,draw );
+
+		int nDiffering = 0;
+		for( size_t i = 0; i < immediate.size(); i++ )
+		{
+			if( immediate[i].dword != binned[i].dword )
+			{
+				nDiffering++;
+			}
+		}
+		std::wcout << name << L" (" << core.second << L"): ";
+		if( nDiffering == 0 )
+		{
+			std::wcout << L"binned matches immediate" << std::endl;
+		}
+		else
+		{
+			std::wcout << nDiffering << L" pixels differ" << std::endl;
+			nFailed++;
+		}
+	}
+	pipeline.SetRasterCore( RasterCore::Scanline );
+	return nFailed;
+}
+
+int BinningCheck::CheckCoverage( Pipeline<AlphaEffect>& pipeline )
+{
+	// black at half alpha over the red clear: every blend halves the red channel
+	constexpr unsigned char redOnce = (unsigned char)(255u * 127u / 256u);
+	const IndexedTriangleList<SolidEffect::Vertex> grid = MakeGrid();
+	const std::vector<SolidEffect::Instance> instance = { {
+		Mat2::Identity(),{ 0.0f,0.0f },Color( 128u,0u,0u,0u ),2.0f } };
+	const std::pair<RasterMode,const wchar_t*> modes[] = {
+		{ RasterMode::Immediate,L"immediate" },
+		{ RasterMode::Binned,L"binned" } };
+	int nFailed = 0;
+	for( const auto& core : cores )
+	{
+		pipeline.SetRasterCore( core.first );
+		for( const auto& mode : modes )
+		{
+			pipeline.SetRasterMode( mode.first );
+			const std::vector<Color> pixels = Render( pipeline,[&]()
+			{
+				pipeline.DrawInstanced( grid,instance );
+			} );
+			int nCounts[3] = {};
+			for( const Color& c : pixels )
+			{
+				nCounts[c.GetR() == 255u ? 0 : c.GetR() == redOnce ? 1 : 2]++;
+			}
+			std::wcout << L"shared edges (" << core.second << L", " << mode.second << L"): " <<
+				nCounts[0] << L" pixels blended 0 times, " << nCounts[1] << L" once, " << nCounts[2] << L" twice or more" << std::endl;
+			if( nCounts[2] != 0 || (nCounts[0] != 0 && core.first != RasterCore::Scanline) )
+			{
+				nFailed++;
+			}
+		}
+	}
+	pipeline.SetRasterCore( RasterCore::Scanline );
+	return nFailed;
+}
+
+template<class Effect,class Draw>
+std::vector<Color> BinningCheck::Render( Pipeline<Effect>& pipeline,Draw draw )
+{
+	gfx.BeginFrame();
+	draw();
+	pipeline.Flush();
+	std::vector<Color> pixels;
+	pixels.reserve( Graphics::ScreenWidth * Graphics::ScreenHeight );
+	for( int y = 0; y < int( Graphics::ScreenHeight ); y++ )
+	{
+		for( int x = 0; x < int( Graphics::ScreenWidth ); x++ )
+		{
+			pixels.push_back( gfx.GetPixel( x,y ) );
+		}
+	}
+	gfx.EndFrame();
+	return pixels;
+}
+
+template<class Vertex,class MakeVertex>
+IndexedTriangleList<Vertex> BinningCheck::MakeTriangles( MakeVertex makeVertex )
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	for( int i = 0; i < nTriangles; i++ )
+	{
+		const Vec2 center = { Random( -1.0f,1.0f ),Random( -1.0f,1.0f ) };
+		const float size = i % 10 == 0 ? 1.5f : 0.3f;
+		for( int j = 0; j < 3; j++ )
+		{
+			indices.push_back( (unsigned int)(vertices.size()) );
+			vertices.push_back( makeVertex( center + Vec2{ Random( -size,size ),Random( -size,size ) } ) );
+		}
+	}
+	return{ std::move( vertices ),std::move( indices ) };
+}
+
+IndexedTriangleList<SolidEffect::Vertex> BinningCheck::MakeGrid()
+{
+	// a little past the screen, so that the outer (unshared) edges are all clipped away
+	constexpr float extent = 1.2f;
+	constexpr float cellSize = 2.0f * extent / float( gridSize );
+	std::vector<SolidEffect::Vertex> vertices;
+	std::vector<unsigned int> indices;
+	for( int y = 0; y <= gridSize; y++ )
+	{
+		for( int x = 0; x <= gridSize; x++ )
+		{
+			Vec2 pos = { -extent + cellSize * float( x ),-extent + cellSize * float( y ) };
+			// at most a fifth of a cell: cells stay convex, either diagonal splits them without a fold
+			if( x > 0 && x < gridSize && y > 0 && y < gridSize )
+			{
+				pos += Vec2{ Random( -0.2f,0.2f ),Random( -0.2f,0.2f ) } * cellSize;
+			}
+			vertices.push_back( pos );
+		}
+	}
+	const unsigned int rowSize = (unsigned int)(gridSize + 1);
+	for( unsigned int y = 0; y < (unsigned int)(gridSize); y++ )
+	{
+		for( unsigned int x = 0; x < (unsigned int)(gridSize); x++ )
+		{
+			const unsigned int i = y * rowSize + x;
+			const unsigned int quad[4] = { i,i + 1,i + rowSize + 1,i + rowSize };
+			const unsigned int first = rng() % 2u;
+			for( unsigned int j : { first,first + 2u } )
+			{
+				indices.push_back( quad[j % 4u] );
+				indices.push_back( quad[(j + 1u) % 4u] );
+				indices.push_back( quad[(j + 2u) % 4u] );
+			}
+		}
+	}
+	return{ std::move( vertices ),std::move( indices ) };
+}
+
+Texture BinningCheck::MakeChecker()
+{
+	Surface surface( 64u,64u );
+	for( unsigned int y = 0; y < surface.GetHeight(); y++ )
+	{
+		for( unsigned int x = 0; x < surface.GetWidth(); x++ )
+		{
+			surface.PutPixel( x,y,((x / 8u + y / 8u) % 2u) ? Color( 255u,255u,255u ) : Color( 60u,60u,60u ) );
+		}
+	}
+	return Texture( surface );
+}
\ No newline at end of file
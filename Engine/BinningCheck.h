@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Graphics.h"
+#include "Pipeline.h"
+#include "SolidEffect.h"
+#include "AlphaEffect.h"
+#include "GradientEffect.h"
+#include "TexturedEffect.h"
+#include "FlatShadeEffect.h"
+#include "Texture.h"
+#include <random>
+#include <utility>
+#include <vector>
+
+// draws the same random triangles through each effect in immediate and in binned mode on every
+// raster core and compares the frames pixel for pixel: tiles clip triangles anywhere, so a binned
+// frame has to come out exactly like the immediate one (which is only clipped to the screen)
+// then blends a translucent mesh over the screen to count how often each pixel gets drawn: pixels on
+// edges shared by two triangles have to be drawn by exactly one of them (top-left rule)
+// (headless main runs it for --check-binning, see HeadlessWindow.h)
+class BinningCheck
+{
+public:
+	BinningCheck( class MainWindow& wnd );
+	BinningCheck( const BinningCheck& ) = delete;
+	BinningCheck& operator=( const BinningCheck& ) = delete;
+	// reports each effect on each core, returns how many of those had pixels differing
+	// (plus how many cores and modes drew shared edge pixels twice, or left holes when exact)
+	int Run();
+private:
+	// draw submits the scene to pipeline, which is left in binned mode
+	template<class Effect,class Draw>
+	int Compare( const wchar_t* name,Pipeline<Effect>& pipeline,Draw draw );
+	// blends MakeGrid through pipeline on every core in both modes and counts the pixels drawn
+	// 0, 1 and more times; scanline's float edges may leave holes, nothing may be drawn twice
+	int CheckCoverage( Pipeline<AlphaEffect>& pipeline );
+	template<class Effect,class Draw>
+	std::vector<Color> Render( Pipeline<Effect>& pipeline,Draw draw );
+	// nTriangles random triangles around the origin, some a lot bigger than the others
+	// makeVertex turns a position into the effect's vertex
+	template<class Vertex,class MakeVertex>
+	IndexedTriangleList<Vertex> MakeTriangles( MakeVertex makeVertex );
+	// gridSize x gridSize cells over (and past) the whole screen, inner vertices jittered and every
+	// cell split along a random diagonal, so that all edges but the outer ones are shared
+	IndexedTriangleList<SolidEffect::Vertex> MakeGrid();
+	float Random( float lo,float hi )
+	{
+		return std::uniform_real_distribution<float>( lo,hi )( rng );
+	}
+	static Texture MakeChecker();
+private:
+	Graphics gfx;
+	static constexpr int nTriangles = 100;
+	static constexpr int nInstances = 30;
+	static constexpr int gridSize = 24;
+	static constexpr std::pair<RasterCore,const wchar_t*> cores[] = {
+		{ RasterCore::Scanline,L"scanline" },
+		{ RasterCore::HalfSpace,L"half-space" },
+		{ RasterCore::FixedPoint,L"fixed point" } };
+	// same triangles every run
+	std::mt19937 rng = std::mt19937( 0u );
+	Texture checker = MakeChecker();
+};
\ No newline at end of file
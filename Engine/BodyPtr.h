@@ -1,5 +1,5 @@
 #pragma once
-#include <Box2D\Box2D.h>
+#include <Box2D/Box2D.h>
 #include <functional>
 #include <memory>
 
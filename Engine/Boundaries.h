@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Box2D\Box2D.h>
+#include <Box2D/Box2D.h>
 #include "IndexedTriangleList.h"
 #include "Vec2.h"
 #include "Vec3.h"
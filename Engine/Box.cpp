@@ -2,6 +2,7 @@
 #include "ColorTraits.h"
 
 IndexedTriangleList<Vec2> Box::model;
+IndexedTriangleList<TexturedEffect::Vertex> Box::texturedModel;
 
 
 std::unique_ptr<Box> Box::Spawn( float size,const Boundaries& bounds,b2World& world,std::mt19937& rng )
@@ -50,7 +51,7 @@ std::vector<std::unique_ptr<Box>> Box::Split( b2World& world )
 	const Vec2 vel = GetVelocity();
 	const float angVel = GetAngularVelocity();
 	// base for rotation to calculate centers of children relative to parent center
-	const Vec2 base = (Vec2{ 0.5f,0.5f } * size) *= Mat2::Rotation( angle );
+	const Vec2 base = (Vec2{ 0.5f,0.5f } * size) * Mat2::Rotation( angle );
 	for( int i = 0; i < 4; i++ )
 	{
 		boxes.push_back( std::make_unique<Box>(
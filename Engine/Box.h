@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Box2D\Box2D.h>
+#include <Box2D/Box2D.h>
 #include "IndexedTriangleList.h"
 #include "Vec2.h"
 #include "Vec3.h"
@@ -8,6 +8,7 @@
 #include "Colors.h"
 #include "Pipeline.h"
 #include "SolidEffect.h"
+#include "TexturedEffect.h"
 #include "BodyPtr.h"
 #include "Boundaries.h"
 #include <random>
@@ -23,7 +24,7 @@ public:
 		virtual std::unique_ptr<ColorTrait> Clone() const = 0;
 	};
 public:
-	static std::unique_ptr<Box> Box::Spawn( float size,const Boundaries& bounds,b2World& world,std::mt19937& rng );
+	static std::unique_ptr<Box> Spawn( float size,const Boundaries& bounds,b2World& world,std::mt19937& rng );
 	Box( std::unique_ptr<ColorTrait> pColorTrait, b2World& world,const Vec2& pos,
 		float size = 1.0f,float angle = 0.0f,Vec2 linVel = {0.0f,0.0f},float angVel = 0.0f )
 		:
@@ -54,11 +55,33 @@ public:
 	}
 	void Draw( Pipeline<SolidEffect>& pepe ) const
 	{
-		pepe.effect.vs.BindTranslation( GetPosition() );
-		pepe.effect.vs.BindRotation( Mat2::Rotation( GetAngle() ) * Mat2::Scaling( GetSize() ) );
-		pepe.effect.ps.BindColor( GetColorTrait().GetColor() );
+		pepe.effect.BindInstance( GetInstance() );
 		pepe.Draw( model );
 	}
+	// state needed to draw this box with the shared model through an instanced draw
+	SolidEffect::Instance GetInstance() const
+	{
+		// model corners are at +-1, so the circumradius is size * sqrt( 2 )
+		return{ Mat2::Rotation( GetAngle() ) * Mat2::Scaling( GetSize() ),GetPosition(),
+			GetColorTrait().GetColor(),GetSize() * 1.41421356f };
+	}
+	static const IndexedTriangleList<Vec2>& GetModel()
+	{
+		Init();
+		return model;
+	}
+	// same as GetInstance, but skinned with texture (tinted with the box color)
+	TexturedEffect::Instance GetTexturedInstance( const Texture& skin ) const
+	{
+		return{ Mat2::Rotation( GetAngle() ) * Mat2::Scaling( GetSize() ),GetPosition(),
+			GetSize() * 1.41421356f,&skin,GetColorTrait().GetColor(),2.0f };
+	}
+	// box model with the texture stretched over the whole box once
+	static const IndexedTriangleList<TexturedEffect::Vertex>& GetTexturedModel()
+	{
+		Init();
+		return texturedModel;
+	}
 	void ApplyLinearImpulse( const Vec2& impulse )
 	{
 		pBody->ApplyLinearImpulse( (b2Vec2)impulse,(b2Vec2)GetPosition(),true );
@@ -103,18 +126,25 @@ public:
 	{
 		pColorTrait = std::move( pct );
 	}
-	std::vector<std::unique_ptr<Box>> Box::Split( b2World& world );
+	std::vector<std::unique_ptr<Box>> Split( b2World& world );
 private:
 	static void Init()
 	{
 		if( model.indices.size() == 0 )
 		{
 			model.vertices = { { -1.0f,-1.0 },{ 1.0f,-1.0 },{ -1.0f,1.0 },{ 1.0f,1.0 } };
-			model.indices = { 0,1,2, 1,2,3 };
+			// both triangles wound clockwise on screen (front facing)
+			model.indices = { 0,2,1, 1,2,3 };
+			// v runs down the texture, world y runs up
+			texturedModel.vertices = {
+				{ { -1.0f,-1.0f },{ 0.0f,1.0f } },{ { 1.0f,-1.0f },{ 1.0f,1.0f } },
+				{ { -1.0f,1.0f },{ 0.0f,0.0f } },{ { 1.0f,1.0f },{ 1.0f,0.0f } } };
+			texturedModel.indices = model.indices;
 		}
 	}
 private:
 	static IndexedTriangleList<Vec2> model;
+	static IndexedTriangleList<TexturedEffect::Vertex> texturedModel;
 	float size;
 	BodyPtr pBody;
 	std::unique_ptr<ColorTrait> pColorTrait;
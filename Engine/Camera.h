@@ -2,15 +2,13 @@
 
 #include "Vec2.h"
 #include "Mat2.h"
-#include "Pipeline.h"
-#include "SolidEffect.h"
 
 class Camera
 {
 public:
 	Camera()
 		:
-		pos( { 0.0f,0.0f } ),
+		pos( 0.0f,0.0f ),
 		zoom( 1.0f )
 	{}
 	void SetZoom( float zoom )
@@ -29,6 +27,13 @@ public:
 	{
 		return zoom;
 	}
+	// true if the circle at center with radius might be visible
+	// (the view is everything that maps to [-1,1] on both axes, 1 / zoom around pos)
+	bool Overlaps( const Vec2& center,float radius ) const
+	{
+		const float extent = 1.0f / zoom + radius;
+		return abs( center.x - pos.x ) <= extent && abs( center.y - pos.y ) <= extent;
+	}
 private:
 	Vec2 pos;
 	float zoom;
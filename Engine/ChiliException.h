@@ -21,6 +21,12 @@
 #pragma once
 #include <string>
 
+// wide version of a narrow string literal (for __FILE__), the msvc crt headers define it
+#ifndef _CRT_WIDE
+#define _CRT_WIDE_( s ) L ## s
+#define _CRT_WIDE( s ) _CRT_WIDE_( s )
+#endif
+
 class ChiliException
 {
 public:
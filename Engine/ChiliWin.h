@@ -20,6 +20,14 @@
 ******************************************************************************************/
 #pragma once
 
+// CHILI_HEADLESS builds run without a window or d3d: Graphics renders into system memory only
+// and the frames can be dumped to disk (see Graphics.h, HeadlessWindow.h)
+// picked at build time, always the backend off windows
+#if !defined( _WIN32 ) && !defined( CHILI_HEADLESS )
+#define CHILI_HEADLESS
+#endif
+
+#ifdef _WIN32
 // target Windows 7 or later
 #define _WIN32_WINNT 0x0601
 #include <sdkddkver.h>
@@ -67,4 +75,7 @@
 
 #define STRICT
 
-#include <Windows.h>
\ No newline at end of file
+#include <Windows.h>
+#else
+typedef unsigned char BYTE;
+#endif
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+// compile-time queries about effects, used by the pipeline to pick specialized paths
+// effects opt in by declaring the corresponding static constexpr members
+
+// which screen space winding gets discarded before rasterization
+// front faces are the ones wound clockwise on screen
+enum class CullMode
+{
+	None,
+	Back,
+	Front
+};
+
+// effect cull mode, effects that don't declare one are not culled
+// declares: static constexpr CullMode cullMode = CullMode::Back;
+template<class Effect,class = void>
+struct EffectCullMode : std::integral_constant<CullMode,CullMode::None>
+{};
+template<class Effect>
+struct EffectCullMode<Effect,std::void_t<decltype(Effect::cullMode)>>
+	:
+	std::integral_constant<CullMode,Effect::cullMode>
+{};
+
+// pixel shader whose output does not depend on its (interpolated) input
+// declares: static constexpr bool isConstant = true; Color GetColor() const;
+template<class PS,class = void>
+struct IsConstantShader : std::false_type
+{};
+template<class PS>
+struct IsConstantShader<PS,std::void_t<decltype(PS::isConstant)>>
+	:
+	std::integral_constant<bool,PS::isConstant>
+{};
+
+// effect that can reject a whole instance before any vertex processing
+// declares: bool IsInstanceVisible( const Instance& ) const;
+template<class Effect,class Instance,class = void>
+struct HasInstanceCulling : std::false_type
+{};
+template<class Effect,class Instance>
+struct HasInstanceCulling<Effect,Instance,
+	std::void_t<decltype(std::declval<const Effect&>().IsInstanceVisible( std::declval<const Instance&>() ))>>
+	:
+	std::true_type
+{};
+
+// pixel shader that can shade a block of FloatBlock::width pixels per call
+// from its attributes laid out structure of arrays (one FloatBlock per attribute)
+// declares: static constexpr int nAttributes = N;
+//           static void LoadAttributes( const Input& in,float* pAttributes ); (N floats out of an interpolant)
+//           void operator()( const FloatBlock* pAttributes,Color* pOut ) const; (N blocks in, width colors out)
+// the regular per-pixel operator() is still needed for the raster cores that shade pixel by pixel
+template<class PS,class = void>
+struct HasBatchShading : std::false_type
+{};
+template<class PS>
+struct HasBatchShading<PS,std::void_t<decltype(PS::nAttributes)>>
+	:
+	std::true_type
+{};
+// number of attributes of a batch shader (1 for other shaders, so that it can always size arrays)
+template<class PS,class = void>
+struct BatchAttributeCount : std::integral_constant<int,1>
+{};
+template<class PS>
+struct BatchAttributeCount<PS,std::void_t<decltype(PS::nAttributes)>>
+	:
+	std::integral_constant<int,PS::nAttributes>
+{};
+// purely 2D effect whose vertex positions are an affine transform of the model
+// the pipeline composes that transform with the screen mapping once per draw (or instance),
+// hands the result to the vs and skips the gs and screen transform stages, z is a per-draw constant
+// declares: static constexpr bool isAffine2D = true;
+//           VertexShader: Affine2 GetTransform() const; (model to normalized device space)
+//                         Output operator()( const Vertex& in,const Affine2& modelToScreen ) const;
+//           GeometryShader must be a pass-through (Output same as the vs Output)
+template<class Effect,class = void>
+struct IsAffine2D : std::false_type
+{};
+template<class Effect>
+struct IsAffine2D<Effect,std::void_t<decltype(Effect::isAffine2D)>>
+	:
+	std::integral_constant<bool,Effect::isAffine2D>
+{};
+// 3D effect whose vertex shader outputs homogeneous clip space positions (Vec4 pos)
+// the pipeline rejects against the view frustum and clips at the near plane (z = 0) in clip space,
+// then divides by w: pos.z becomes depth (0 near ~ 1 far), pos.w holds 1/w and all other attributes
+// are divided by w so they interpolate linearly in screen space, raster cores multiply by the
+// interpolated w again (perspective correct) before handing them to the pixel shader
+// declares: static constexpr bool isPerspective = true;
+template<class Effect,class = void>
+struct IsPerspective : std::false_type
+{};
+template<class Effect>
+struct IsPerspective<Effect,std::void_t<decltype(Effect::isPerspective)>>
+	:
+	std::integral_constant<bool,Effect::isPerspective>
+{};
+// vertex shader that shades whole arrays of vertices per call instead of one vertex at a time,
+// so that it can transform them FloatBlock::width at a time (see VertexBlock.h)
+// declares: static constexpr bool isBatched = true;
+//           void operator()( const Vertex* pIn,Output* pOut,size_t count ) const;
+//           (2D affine effects take the composed transform instead:
+//            void operator()( const Vertex* pIn,Output* pOut,size_t count,const Affine2& modelToScreen ) const;)
+// the per-vertex operator() is still needed (quads go through it), and both have to give the same output
+template<class VS,class = void>
+struct HasBatchVertexShading : std::false_type
+{};
+template<class VS>
+struct HasBatchVertexShading<VS,std::void_t<decltype(VS::isBatched)>>
+	:
+	std::integral_constant<bool,VS::isBatched>
+{};
+// constant color pixel shader whose color is alpha composited over the render target
+// (Surface::Blend with the color's alpha) instead of replacing it
+// translucent fills don't hide anything, so span occlusion and multisampling aren't available,
+// with depth testing they still write depth: draw them after the opaque geometry, back to front
+// pixels on edges shared by two triangles are blended exactly once by the half-space and fixed point
+// cores; scanline never blends one twice but can leave the odd one out (a hole where the float edges
+// of both triangles round away from it), --check-binning counts them (quads don't have shared edges)
+// declares: static constexpr bool isBlended = true; (and is a constant shader, see IsConstantShader)
+template<class PS,class = void>
+struct IsAlphaBlended : std::false_type
+{};
+template<class PS>
+struct IsAlphaBlended<PS,std::void_t<decltype(PS::isBlended)>>
+	:
+	std::integral_constant<bool,PS::isBlended>
+{};
\ No newline at end of file
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "Pipeline.h"
+#include "Mat4.h"
+#include "Vec4.h"
+#include "VertexBlock.h"
+
+// 3D meshes lit by one directional light plus ambient, one color per face
+// face normals come from the world space positions in the gs, so meshes don't need vertex normals
+// goes through the pipeline's perspective path (see IsPerspective)
+class FlatShadeEffect
+{
+public:
+	// vs outputs clip space, pipeline clips and does the perspective divide
+	static constexpr bool isPerspective = true;
+	// faces wound clockwise when seen from the front
+	static constexpr CullMode cullMode = CullMode::Back;
+	// the vertex type that will be input into the pipeline
+	class Vertex
+	{
+	public:
+		Vec3 pos;
+	};
+	// transforms vertices to clip space, keeps the world position for lighting in the gs
+	class VertexShader
+	{
+	public:
+		class Output
+		{
+		public:
+			Output() = default;
+			Output( const Vec4& pos,const Vec3& world )
+				:
+				pos( pos ),
+				world( world )
+			{}
+			Output& operator+=( const Output& rhs )
+			{
+				pos += rhs.pos;
+				world += rhs.world;
+				return *this;
+			}
+			Output operator+( const Output& rhs ) const
+			{
+				return Output( *this ) += rhs;
+			}
+			Output& operator-=( const Output& rhs )
+			{
+				pos -= rhs.pos;
+				world -= rhs.world;
+				return *this;
+			}
+			Output operator-( const Output& rhs ) const
+			{
+				return Output( *this ) -= rhs;
+			}
+			Output& operator*=( float rhs )
+			{
+				pos *= rhs;
+				world *= rhs;
+				return *this;
+			}
+			Output operator*( float rhs ) const
+			{
+				return Output( *this ) *= rhs;
+			}
+			Output& operator/=( float rhs )
+			{
+				pos /= rhs;
+				world /= rhs;
+				return *this;
+			}
+			Output operator/( float rhs ) const
+			{
+				return Output( *this ) /= rhs;
+			}
+		public:
+			Vec4 pos;
+			Vec3 world;
+		};
+		// shades whole arrays of vertices (see HasBatchVertexShading)
+		static constexpr bool isBatched = true;
+	public:
+		// model to world
+		void BindWorld( const Mat4& world_in )
+		{
+			world = world_in;
+			worldViewProj = world * viewProj;
+		}
+		// world to clip space (camera and projection)
+		void BindViewProjection( const Mat4& viewProj_in )
+		{
+			viewProj = viewProj_in;
+			worldViewProj = world * viewProj;
+		}
+		Output operator()( const Vertex& in ) const
+		{
+			const Vec4 pos( in.pos );
+			return{ pos * worldViewProj,pos * world };
+		}
+		void operator()( const Vertex* pIn,Output* pOut,size_t count ) const
+		{
+			ForEachBlock( count,[&]( size_t first,int n )
+			{
+				const PointBlock3 pos = PointBlock3::Load( &pIn[first].pos,sizeof( Vertex ),n );
+				(pos * worldViewProj).Store( &pOut[first].pos,sizeof( Output ),n );
+				pos.TransformAffine( world ).Store( &pOut[first].world,sizeof( Output ),n );
+			} );
+		}
+	private:
+		Mat4 world = Mat4::Identity();
+		Mat4 viewProj = Mat4::Identity();
+		Mat4 worldViewProj = Mat4::Identity();
+	};
+	// lights each triangle with its face normal, outputs the color on all 3 vertices
+	class GeometryShader
+	{
+	public:
+		class Output
+		{
+		public:
+			Output() = default;
+			Output( const Vec4& pos,const Vec3& color )
+				:
+				pos( pos ),
+				color( color )
+			{}
+			Output& operator+=( const Output& rhs )
+			{
+				pos += rhs.pos;
+				color += rhs.color;
+				return *this;
+			}
+			Output operator+( const Output& rhs ) const
+			{
+				return Output( *this ) += rhs;
+			}
+			Output& operator-=( const Output& rhs )
+			{
+				pos -= rhs.pos;
+				color -= rhs.color;
+				return *this;
+			}
+			Output operator-( const Output& rhs ) const
+			{
+				return Output( *this ) -= rhs;
+			}
+			Output& operator*=( float rhs )
+			{
+				pos *= rhs;
+				color *= rhs;
+				return *this;
+			}
+			Output operator*( float rhs ) const
+			{
+				return Output( *this ) *= rhs;
+			}
+			Output& operator/=( float rhs )
+			{
+				pos /= rhs;
+				color /= rhs;
+				return *this;
+			}
+			Output operator/( float rhs ) const
+			{
+				return Output( *this ) /= rhs;
+			}
+		public:
+			Vec4 pos;
+			// rgb in 0-255
+			Vec3 color;
+		};
+	public:
+		// world space direction the light travels in
+		void BindLightDirection( const Vec3& dir )
+		{
+			lightDir = dir.GetNormalized();
+		}
+		// light and ambient intensities per channel, 0-1
+		void BindLight( const Vec3& diffuse_in,const Vec3& ambient_in )
+		{
+			diffuse = diffuse_in;
+			ambient = ambient_in;
+		}
+		void BindMaterial( Color c )
+		{
+			material = { float( c.GetR() ),float( c.GetG() ),float( c.GetB() ) };
+		}
+		Triangle<Output> operator()( const VertexShader::Output& in0,const VertexShader::Output& in1,const VertexShader::Output& in2,size_t triangle_index ) const
+		{
+			const Vec3 n = ((in1.world - in0.world) % (in2.world - in0.world)).GetNormalized();
+			const float d = std::max( 0.0f,-(n * lightDir) );
+			const Vec3 light = (diffuse * d + ambient).GetSaturated();
+			const Vec3 color = material.GetHadamard( light );
+			return{ { in0.pos,color },{ in1.pos,color },{ in2.pos,color } };
+		}
+	private:
+		Vec3 lightDir = Vec3( 0.3f,-0.6f,1.0f ).GetNormalized();
+		Vec3 diffuse = { 1.0f,1.0f,1.0f };
+		Vec3 ambient = { 0.15f,0.15f,0.15f };
+		Vec3 material = { 200.0f,200.0f,200.0f };
+	};
+	// outputs the interpolated (perspective corrected) color
+	class PixelShader
+	{
+	public:
+		template<class I>
+		Color operator()( const I& in ) const
+		{
+			return Color( in.color );
+		}
+	};
+	// per-instance state for instanced draws
+	class Instance
+	{
+	public:
+		Mat4 world;
+		Color color;
+	};
+public:
+	void BindInstance( const Instance& inst )
+	{
+		vs.BindWorld( inst.world );
+		gs.BindMaterial( inst.color );
+	}
+public:
+	VertexShader vs;
+	GeometryShader gs;
+	PixelShader ps;
+};
\ No newline at end of file
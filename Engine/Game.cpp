@@ -34,10 +34,17 @@ Game::Game( MainWindow& wnd )
 	wnd( wnd ),
 	gfx( wnd ),
 	world( { 0.0f,-0.5f } ),
-	pepe( gfx )
+	pepe( gfx ),
+	texPepe( gfx ),
+	alphaPepe( gfx )
 {
 	pepe.effect.vs.cam.SetPos( { 0.0,0.0f } );
 	pepe.effect.vs.cam.SetZoom( 1.0f / boundarySize );
+	pepe.SetRasterMode( RasterMode::Binned );
+	texPepe.effect.vs.cam = pepe.effect.vs.cam;
+	texPepe.SetRasterMode( RasterMode::Binned );
+	alphaPepe.effect.vs.cam = pepe.effect.vs.cam;
+	alphaPepe.SetRasterMode( RasterMode::Binned );
 
 	std::generate_n( std::back_inserter( boxPtrs ),nBoxes,[this]() {
 		return Box::Spawn( boxSize,bounds,world,rng );
@@ -76,7 +83,63 @@ void Game::Go()
 
 void Game::UpdateModel()
 {
+	while( !wnd.kbd.KeyIsEmpty() )
+	{
+		const auto e = wnd.kbd.ReadKey();
+		if( e.IsPress() && e.GetCode() == 'B' )
+		{
+			// toggle between tile binned and immediate rasterization for comparison
+			const RasterMode mode = pepe.GetRasterMode() == RasterMode::Binned ?
+				RasterMode::Immediate : RasterMode::Binned;
+			pepe.SetRasterMode( mode );
+			texPepe.SetRasterMode( mode );
+			alphaPepe.SetRasterMode( mode );
+		}
+		else if( e.IsPress() && e.GetCode() == 'H' )
+		{
+			// cycle scanline -> half-space -> fixed point raster cores
+			switch( pepe.GetRasterCore() )
+			{
+			case RasterCore::Scanline:
+				pepe.SetRasterCore( RasterCore::HalfSpace );
+				break;
+			case RasterCore::HalfSpace:
+				pepe.SetRasterCore( RasterCore::FixedPoint );
+				break;
+			default:
+				pepe.SetRasterCore( RasterCore::Scanline );
+				break;
+			}
+			texPepe.SetRasterCore( pepe.GetRasterCore() );
+			alphaPepe.SetRasterCore( pepe.GetRasterCore() );
+		}
+		else if( e.IsPress() && e.GetCode() == 'O' )
+		{
+			// toggle span occlusion for the flat colored boxes (overdraw comparison)
+			pepe.SetSpanOcclusion( !pepe.GetSpanOcclusion() );
+		}
+		else if( e.IsPress() && e.GetCode() == 'M' )
+		{
+			// toggle 4x multisample antialiasing for the flat colored boxes
+			pepe.SetMultisampling( !pepe.GetMultisampling() );
+		}
+		else if( e.IsPress() && e.GetCode() == 'T' )
+		{
+			// toggle flat colored / textured (color tinted) boxes
+			drawTextured = !drawTextured;
+		}
+		else if( e.IsPress() && e.GetCode() == 'G' )
+		{
+			// toggle translucent (alpha blended) flat colored boxes
+			drawTranslucent = !drawTranslucent;
+		}
+	}
+#ifdef CHILI_HEADLESS
+	// fixed step, headless frames come as fast as they render
+	const float dt = 1.0f / 60.0f;
+#else
 	const float dt = ft.Mark();
+#endif
 	world.Step( dt,8,3 );
 	// process generated actions
 	for( auto& pa : actionPtrs )
@@ -93,8 +156,51 @@ void Game::UpdateModel()
 
 void Game::ComposeFrame()
 {
-	for( const auto& p : boxPtrs )
+	// gather per-box state and draw all boxes with a single instanced draw
+	if( drawTextured )
 	{
-		p->Draw( pepe );
+		texturedBoxInstances.clear();
+		std::transform( boxPtrs.begin(),boxPtrs.end(),std::back_inserter( texturedBoxInstances ),
+			[this]( const std::unique_ptr<Box>& p ) { return p->GetTexturedInstance( boxSkin ); } );
+		texPepe.DrawInstanced( Box::GetTexturedModel(),texturedBoxInstances );
+		texPepe.Flush();
+	}
+	else
+	{
+		boxInstances.clear();
+		std::transform( boxPtrs.begin(),boxPtrs.end(),std::back_inserter( boxInstances ),
+			[]( const std::unique_ptr<Box>& p ) { return p->GetInstance(); } );
+		if( drawTranslucent )
+		{
+			for( auto& inst : boxInstances )
+			{
+				inst.color.SetA( translucentAlpha );
+			}
+			alphaPepe.DrawInstancedQuads( Box::GetModel(),boxInstances );
+			alphaPepe.Flush();
+		}
+		else
+		{
+			pepe.DrawInstancedQuads( Box::GetModel(),boxInstances );
+			pepe.Flush();
+		}
+	}
+}
+
+Texture Game::LoadBoxSkin()
+{
+#ifdef CHILI_HEADLESS
+	// no jpeg decoding without gdi+ (headless only reads bmp), a checkerboard stands in for the wood
+	Surface skin( 64u,64u );
+	for( unsigned int y = 0; y < skin.GetHeight(); y++ )
+	{
+		for( unsigned int x = 0; x < skin.GetWidth(); x++ )
+		{
+			skin.PutPixel( x,y,((x / 8u + y / 8u) % 2u) ? Color( 200u,150u,90u ) : Color( 120u,75u,35u ) );
+		}
 	}
+	return Texture( skin );
+#else
+	return Texture::FromFile( L"Images\\wood.jpg" );
+#endif
 }
\ No newline at end of file
@@ -24,11 +24,14 @@
 #include <memory>
 #include <vector>
 #include "FrameTimer.h"
-#include <Box2D\Box2D.h>
+#include <Box2D/Box2D.h>
 #include "Box.h"
 #include "Boundaries.h"
 #include "Pipeline.h"
 #include "SolidEffect.h"
+#include "TexturedEffect.h"
+#include "AlphaEffect.h"
+#include "Texture.h"
 #include <random>
 #include "Action.h"
 
@@ -39,11 +42,17 @@ public:
 	Game( const Game& ) = delete;
 	Game& operator=( const Game& ) = delete;
 	void Go();
+	// scratch storage growths of all the pipelines (debug builds only, see Pipeline::GetScratchGrowthCount)
+	size_t GetScratchGrowthCount() const
+	{
+		return pepe.GetScratchGrowthCount() + texPepe.GetScratchGrowthCount() + alphaPepe.GetScratchGrowthCount();
+	}
 private:
 	void ComposeFrame();
 	void UpdateModel();
 	/********************************/
 	/*  User Functions              */
+	static Texture LoadBoxSkin();
 	/********************************/
 private:
 	MainWindow& wnd;
@@ -53,12 +62,25 @@ private:
 	static constexpr float boundarySize = 10.0f;
 	static constexpr float boxSize = 1.0f;
 	static constexpr int nBoxes = 6;
+	static constexpr unsigned char translucentAlpha = 160u;
+#ifdef CHILI_HEADLESS
+	// same boxes every run, headless runs are for comparing timings
+	std::mt19937 rng = std::mt19937( 0u );
+#else
 	std::mt19937 rng = std::mt19937( std::random_device{}() );
+#endif
 	FrameTimer ft;
 	Pipeline<SolidEffect> pepe;
+	Pipeline<TexturedEffect> texPepe;
+	Pipeline<AlphaEffect> alphaPepe;
+	Texture boxSkin = LoadBoxSkin();
+	bool drawTextured = false;
+	bool drawTranslucent = false;
 	b2World world;
 	Boundaries bounds = Boundaries( world,boundarySize );
 	std::vector<std::unique_ptr<Box>> boxPtrs;
+	std::vector<SolidEffect::Instance> boxInstances;
+	std::vector<TexturedEffect::Instance> texturedBoxInstances;
 	std::vector<std::unique_ptr<Action>> actionPtrs;
 	/********************************/
 };
\ No newline at end of file
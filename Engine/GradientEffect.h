@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Pipeline.h"
+#include "DefaultGeometryShader.h"
+#include "SimdBlock.h"
+#include "Mat2.h"
+#include "Affine2.h"
+#include "Camera.h"
+
+// color attribute given per vertex and interpolated across the triangle
+// pixel shader supports batch shading (see HasBatchShading)
+class GradientEffect
+{
+public:
+	// 2D only, pipeline takes the affine path (see IsAffine2D)
+	static constexpr bool isAffine2D = true;
+	// the vertex type that will be input into the pipeline
+	class Vertex
+	{
+	public:
+		Vec2 pos;
+		// rgb in 0-255
+		Vec3 color;
+	};
+	// rotates and translates vertices, passes color through
+	class VertexShader
+	{
+	public:
+		class Output
+		{
+		public:
+			Output() = default;
+			Output( const Vec3& pos,const Vec3& color )
+				:
+				pos( pos ),
+				color( color )
+			{}
+			Output& operator+=( const Output& rhs )
+			{
+				pos += rhs.pos;
+				color += rhs.color;
+				return *this;
+			}
+			Output operator+( const Output& rhs ) const
+			{
+				return Output( *this ) += rhs;
+			}
+			Output& operator-=( const Output& rhs )
+			{
+				pos -= rhs.pos;
+				color -= rhs.color;
+				return *this;
+			}
+			Output operator-( const Output& rhs ) const
+			{
+				return Output( *this ) -= rhs;
+			}
+			Output& operator*=( float rhs )
+			{
+				pos *= rhs;
+				color *= rhs;
+				return *this;
+			}
+			Output operator*( float rhs ) const
+			{
+				return Output( *this ) *= rhs;
+			}
+			Output& operator/=( float rhs )
+			{
+				pos /= rhs;
+				color /= rhs;
+				return *this;
+			}
+			Output operator/( float rhs ) const
+			{
+				return Output( *this ) /= rhs;
+			}
+		public:
+			Vec3 pos;
+			Vec3 color;
+		};
+		Camera cam;
+	public:
+		void BindRotation( const Mat2& rotation_in )
+		{
+			rotation = rotation_in;
+		}
+		void BindTranslation( const Vec2& translation_in )
+		{
+			translation = translation_in;
+		}
+		// layer depth written to z (smaller is closer when depth testing)
+		void BindDepth( float depth_in )
+		{
+			depth = depth_in;
+		}
+		Output operator()( const Vertex& in ) const
+		{
+			const Vec2 xformd = (in.pos * rotation + translation + cam.GetTranslation()) * cam.GetZoom();
+			return{ { xformd.x,xformd.y,depth },in.color };
+		}
+		// model to normalized device space, for the pipeline's 2D affine path
+		Affine2 GetTransform() const
+		{
+			return{ rotation * cam.GetZoom(),(translation + cam.GetTranslation()) * cam.GetZoom() };
+		}
+		Output operator()( const Vertex& in,const Affine2& modelToScreen ) const
+		{
+			const Vec2 xformd = in.pos * modelToScreen;
+			return{ { xformd.x,xformd.y,depth },in.color };
+		}
+	private:
+		Mat2 rotation;
+		Vec2 translation;
+		float depth = 1.0f;
+	};
+	// default gs passes vertices through and outputs triangle
+	typedef DefaultGeometryShader<VertexShader::Output> GeometryShader;
+	// outputs the interpolated color
+	class PixelShader
+	{
+	public:
+		// r,g,b
+		static constexpr int nAttributes = 3;
+	public:
+		template<class I>
+		static void LoadAttributes( const I& in,float* pAttributes )
+		{
+			pAttributes[0] = in.color.x;
+			pAttributes[1] = in.color.y;
+			pAttributes[2] = in.color.z;
+		}
+		template<class I>
+		Color operator()( const I& in ) const
+		{
+			return Color( in.color );
+		}
+		void operator()( const FloatBlock* pAttributes,Color* pOut ) const
+		{
+			StoreColors( pAttributes[0],pAttributes[1],pAttributes[2],pOut );
+		}
+	};
+	// per-instance state for instanced draws
+	class Instance
+	{
+	public:
+		Mat2 rotation;
+		Vec2 translation;
+		// radius of a circle around translation that contains the whole transformed model
+		float boundingRadius;
+	};
+public:
+	bool IsInstanceVisible( const Instance& inst ) const
+	{
+		return vs.cam.Overlaps( inst.translation,inst.boundingRadius );
+	}
+	void BindInstance( const Instance& inst )
+	{
+		vs.BindRotation( inst.rotation );
+		vs.BindTranslation( inst.translation );
+	}
+public:
+	VertexShader vs;
+	GeometryShader gs;
+	PixelShader ps;
+};
\ No newline at end of file
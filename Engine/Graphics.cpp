@@ -20,12 +20,15 @@
 ******************************************************************************************/
 #include "MainWindow.h"
 #include "Graphics.h"
-#include "DXErr.h"
 #include "ChiliException.h"
 #include <assert.h>
 #include <string>
 #include <array>
 #include <functional>
+#include <algorithm>
+
+#ifndef CHILI_HEADLESS
+#include "DXErr.h"
 
 // Ignore the intellisense error "cannot open source file" for .shh files.
 // They will be created during the build sequence before the preprocessor runs.
@@ -41,7 +44,8 @@ using Microsoft::WRL::ComPtr;
 
 Graphics::Graphics( HWNDKey& key )
 	:
-	sysBuffer( ScreenWidth,ScreenHeight )
+	// with direct mapping there is no buffer until BeginFrame maps the texture
+	sysBuffer( DirectMapping ? Surface( SurfaceView() ) : Surface( ScreenWidth,ScreenHeight,SysBufferLayout ) )
 {
 	assert( key.hWnd != nullptr );
 
@@ -250,17 +254,33 @@ void Graphics::EndFrame()
 {
 	HRESULT hr;
 
-	// lock and map the adapter memory for copying over the sysbuffer
-	if( FAILED( hr = pImmediateContext->Map( pSysBufferTexture.Get(),0u,
-		D3D11_MAP_WRITE_DISCARD,0u,&mappedSysBufferTexture ) ) )
+	// antialiased edge pixels get their final color
+	if( pMultisampleBuffer )
+	{
+		pMultisampleBuffer->Resolve( sysBuffer );
+	}
+
+	if( DirectMapping )
+	{
+		// the frame is already in the texture, release it (and don't let anything draw
+		// into it until the next BeginFrame maps it again)
+		pImmediateContext->Unmap( pSysBufferTexture.Get(),0u );
+		sysBuffer = Surface( SurfaceView() );
+	}
+	else
 	{
-		throw CHILI_GFX_EXCEPTION( hr,L"Mapping sysbuffer" );
+		// lock and map the adapter memory for copying over the sysbuffer
+		if( FAILED( hr = pImmediateContext->Map( pSysBufferTexture.Get(),0u,
+			D3D11_MAP_WRITE_DISCARD,0u,&mappedSysBufferTexture ) ) )
+		{
+			throw CHILI_GFX_EXCEPTION( hr,L"Mapping sysbuffer" );
+		}
+		// perform the copy line-by-line
+		sysBuffer.Present( mappedSysBufferTexture.RowPitch,
+			reinterpret_cast<BYTE*>(mappedSysBufferTexture.pData) );
+		// release the adapter memory
+		pImmediateContext->Unmap( pSysBufferTexture.Get(),0u );
 	}
-	// perform the copy line-by-line
-	sysBuffer.Present( mappedSysBufferTexture.RowPitch,
-		reinterpret_cast<BYTE*>(mappedSysBufferTexture.pData) );
-	// release the adapter memory
-	pImmediateContext->Unmap( pSysBufferTexture.Get(),0u );
 
 	// render offscreen scene texture to back buffer
 	pImmediateContext->IASetInputLayout( pInputLayout.Get() );
@@ -281,12 +301,99 @@ void Graphics::EndFrame()
 	}
 }
 
+#else
+
+Graphics::Graphics( HWNDKey& key )
+	:
+	dumpPath( key.dumpPath ),
+	dumpInterval( std::max( key.dumpInterval,1u ) ),
+	sysBuffer( ScreenWidth,ScreenHeight,SysBufferLayout )
+{
+	// dumped frames skip the copy into a bmp (a view can only be linear)
+	if( !dumpPath.empty() && SysBufferLayout == Surface::Layout::Linear )
+	{
+		dumpBitmap = Surface::MakeBitmap( ScreenWidth,ScreenHeight );
+		SetRenderTarget( Surface::GetBitmapView( dumpBitmap,ScreenWidth,ScreenHeight ) );
+	}
+}
+
+Graphics::~Graphics()
+{}
+
+void Graphics::EndFrame()
+{
+	// antialiased edge pixels get their final color
+	if( pMultisampleBuffer )
+	{
+		pMultisampleBuffer->Resolve( sysBuffer );
+	}
+
+	// no adapter to present to, the frame only leaves memory when it gets dumped
+	if( !dumpPath.empty() && frameIndex % dumpInterval == 0u )
+	{
+		const std::wstring filename = dumpPath + std::to_wstring( frameIndex ) + L".bmp";
+		if( dumpBitmap.empty() )
+		{
+			sysBuffer.Save( filename );
+		}
+		else
+		{
+			Surface::SaveBitmap( filename,dumpBitmap );
+		}
+	}
+	frameIndex++;
+}
+#endif
+
+void Graphics::SetRenderTarget( const SurfaceView& view )
+{
+	// a mapped texture already is the render target
+	assert( !DirectMapping );
+	if( view.pPixels == nullptr )
+	{
+		sysBuffer = Surface( ScreenWidth,ScreenHeight,SysBufferLayout );
+	}
+	else
+	{
+		assert( view.width == ScreenWidth );
+		assert( view.height == ScreenHeight );
+		sysBuffer = Surface( view );
+	}
+}
+
 void Graphics::BeginFrame()
 {
+#ifndef CHILI_HEADLESS
+	if( DirectMapping )
+	{
+		// the frame gets drawn straight into the adapter memory
+		HRESULT hr;
+		if( FAILED( hr = pImmediateContext->Map( pSysBufferTexture.Get(),0u,
+			D3D11_MAP_WRITE_DISCARD,0u,&mappedSysBufferTexture ) ) )
+		{
+			throw CHILI_GFX_EXCEPTION( hr,L"Mapping sysbuffer" );
+		}
+		sysBuffer = Surface( SurfaceView::FromBytePitch( mappedSysBufferTexture.pData,
+			ScreenWidth,ScreenHeight,mappedSysBufferTexture.RowPitch ) );
+	}
+#endif
 	sysBuffer.Clear( Colors::Red );
+	if( pZBuffer )
+	{
+		pZBuffer->Clear();
+	}
+	if( pSpanBuffer )
+	{
+		pSpanBuffer->Clear();
+	}
+	if( pMultisampleBuffer )
+	{
+		pMultisampleBuffer->Clear();
+	}
 }
 
 
+#ifndef CHILI_HEADLESS
 //////////////////////////////////////////////////
 //           Graphics Exception
 Graphics::Exception::Exception( HRESULT hr,const std::wstring& note,const wchar_t* file,unsigned int line )
@@ -328,6 +435,7 @@ std::wstring Graphics::Exception::GetExceptionType() const
 {
 	return L"Chili Graphics Exception";
 }
+#endif
 
 void Graphics::DrawLine( float x1,float y1,float x2,float y2,Color c )
 {
@@ -19,18 +19,29 @@
 *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
 ******************************************************************************************/
 #pragma once
+#include "ChiliWin.h"
+#ifndef CHILI_HEADLESS
 #include <d3d11.h>
 #include <wrl.h>
 #include "GDIPlusManager.h"
+#endif
 #include "ChiliException.h"
 #include "Surface.h"
+#include "ZBuffer.h"
+#include "SpanBuffer.h"
+#include "MultisampleBuffer.h"
 #include "Colors.h"
 #include "Vec2.h"
+#include <string>
+#include <vector>
 
+#ifndef CHILI_HEADLESS
 #define CHILI_GFX_EXCEPTION( hr,note ) Graphics::Exception( hr,note,_CRT_WIDE(__FILE__),__LINE__ )
+#endif
 
 class Graphics
 {
+#ifndef CHILI_HEADLESS
 public:
 	class Exception : public ChiliException
 	{
@@ -50,12 +61,17 @@ private:
 		float x,y,z;		// position
 		float u,v;			// texcoords
 	};
+#endif
 public:
 	Graphics( class HWNDKey& key );
 	Graphics( const Graphics& ) = delete;
 	Graphics& operator=( const Graphics& ) = delete;
 	void EndFrame();
 	void BeginFrame();
+	// frames from the next BeginFrame on are drawn into view (ScreenWidth x ScreenHeight) instead of
+	// the sysbuffer's own memory, an empty view goes back to the own memory
+	// the view has to outlive its use, nothing of it is read but the pixels drawn
+	void SetRenderTarget( const SurfaceView& view );
 	void DrawLine( const Vec2& p1,const Vec2& p2,Color c )
 	{
 		DrawLine( p1.x,p1.y,p2.x,p2.y,c );
@@ -63,14 +79,87 @@ public:
 	void DrawLine( float x1,float y1,float x2,float y2,Color c );
 	void PutPixel( int x,int y,int r,int g,int b )
 	{
-		PutPixel( x,y,{ unsigned char( r ),unsigned char( g ),unsigned char( b ) } );
+		PutPixel( x,y,{ (unsigned char)( r ),(unsigned char)( g ),(unsigned char)( b ) } );
 	}
 	void PutPixel( int x,int y,Color c )
 	{
 		sysBuffer.PutPixel( x,y,c );
 	}
+	void PutPixelsMasked( int x,int y,const Color* pColors,unsigned int mask,int count )
+	{
+		sysBuffer.PutPixelsMasked( x,y,pColors,mask,count );
+	}
+	void FillSpan( int xStart,int xEnd,int y,Color c )
+	{
+		sysBuffer.FillSpan( xStart,xEnd,y,c );
+	}
+	void PutPixelAlpha( int x,int y,Color c )
+	{
+		sysBuffer.PutPixelAlpha( x,y,c );
+	}
+	void BlendSpan( int xStart,int xEnd,int y,Color c )
+	{
+		sysBuffer.BlendSpan( xStart,xEnd,y,c );
+	}
+	void BlendRect( const RectI& rect,Color c )
+	{
+		sysBuffer.BlendRect( rect,c );
+	}
+	void FillRect( const RectI& rect,Color c )
+	{
+		sysBuffer.FillRect( rect,c );
+	}
+	void Blit( const Surface& src,const RectI& srcRect,int x,int y )
+	{
+		sysBuffer.Blit( src,srcRect,x,y );
+	}
+	void Blit( const Surface& src,int x,int y )
+	{
+		sysBuffer.Blit( src,x,y );
+	}
+	Color GetPixel( int x,int y ) const
+	{
+		return sysBuffer.GetPixel( x,y );
+	}
+	// depth buffer is created the first time somebody asks for it
+	// and from then on cleared along with the sysbuffer every frame
+	ZBuffer& GetZBuffer()
+	{
+		if( !pZBuffer )
+		{
+			pZBuffer = std::make_unique<ZBuffer>( int( ScreenWidth ),int( ScreenHeight ) );
+		}
+		return *pZBuffer;
+	}
+	// same for the span coverage buffer
+	SpanBuffer& GetSpanBuffer()
+	{
+		if( !pSpanBuffer )
+		{
+			pSpanBuffer = std::make_unique<SpanBuffer>( int( ScreenWidth ),int( ScreenHeight ) );
+		}
+		return *pSpanBuffer;
+	}
+	// same for the multisample buffer, its edge pixels are resolved at the start of EndFrame
+	MultisampleBuffer& GetMultisampleBuffer()
+	{
+		if( !pMultisampleBuffer )
+		{
+			pMultisampleBuffer = std::make_unique<MultisampleBuffer>( int( ScreenWidth ),int( ScreenHeight ) );
+		}
+		return *pMultisampleBuffer;
+	}
 	~Graphics();
 private:
+#ifdef CHILI_HEADLESS
+	// every dumpInterval-th frame is saved as <dumpPath><frame>.bmp, nothing if the path is empty
+	// (settings come from the window, see HeadlessWindow.h)
+	std::wstring										dumpPath;
+	unsigned int										dumpInterval;
+	unsigned int										frameIndex = 0u;
+	// bmp file image the frames are drawn into when dumping, saved as is (see Surface::MakeBitmap)
+	std::vector<Color>									dumpBitmap;
+#else
 	GDIPlusManager										gdipMan;
 	Microsoft::WRL::ComPtr<IDXGISwapChain>				pSwapChain;
 	Microsoft::WRL::ComPtr<ID3D11Device>				pDevice;
@@ -84,8 +173,23 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11InputLayout>			pInputLayout;
 	Microsoft::WRL::ComPtr<ID3D11SamplerState>			pSamplerState;
 	D3D11_MAPPED_SUBRESOURCE							mappedSysBufferTexture;
+#endif
 	Surface												sysBuffer;
+	std::unique_ptr<ZBuffer>							pZBuffer;
+	std::unique_ptr<SpanBuffer>							pSpanBuffer;
+	std::unique_ptr<MultisampleBuffer>					pMultisampleBuffer;
 public:
 	static constexpr unsigned int ScreenWidth = 800u;
 	static constexpr unsigned int ScreenHeight = 800u;
+	// memory layout of the sysbuffer the frame is rasterized into (Present detiles a tiled one)
+	// tiled only pays off when the frame doesn't stay in the cache, on a desktop with a large
+	// L2/L3 the extra span splitting made linear the faster one
+	static constexpr Surface::Layout SysBufferLayout = Surface::Layout::Linear;
+	// rasterize straight into the mapped sysbuffer texture (mapped from BeginFrame to EndFrame,
+	// through a SurfaceView) instead of into system memory that EndFrame copies over
+	// saves the full frame copy, but the mapping is write-combined memory: whatever reads the frame
+	// back (alpha blending, multisample edges) gets very slow, so it only suits opaque fills
+	// (d3d backend only, headless always renders into system memory)
+	static constexpr bool DirectMapping = false;
+	static_assert(!DirectMapping || SysBufferLayout == Surface::Layout::Linear,"mapped textures are linear");
 };
\ No newline at end of file
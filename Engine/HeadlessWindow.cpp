@@ -0,0 +1,79 @@
+#include "MainWindow.h"
+#ifdef CHILI_HEADLESS
+#include <iostream>
+#include <sstream>
+#include <cctype>
+
+MainWindow::MainWindow( int argc,char* argv[] )
+{
+	for( int i = 1; i < argc; i++ )
+	{
+		const std::string arg = argv[i];
+		const std::wstring wideArg( arg.begin(),arg.end() );
+		args += (i > 1 ? L" " : L"") + wideArg;
+
+		const auto eq = arg.find( '=' );
+		const std::string name = arg.substr( 0,eq );
+		const std::string value = eq == std::string::npos ? "" : arg.substr( eq + 1 );
+		try
+		{
+			if( name == "--frames" )
+			{
+				frameLimit = (unsigned int)(std::stoul( value ));
+			}
+			else if( name == "--keys" )
+			{
+				keys = value;
+			}
+			else if( name == "--dump" )
+			{
+				dumpPath = wideArg.substr( eq + 1 );
+			}
+			else if( name == "--model" )
+			{
+				modelFilename = wideArg.substr( eq + 1 );
+			}
+			else if( arg == "--check-binning" )
+			{
+				binningCheck = true;
+			}
+			else if( name == "--every" )
+			{
+				dumpInterval = (unsigned int)(std::stoul( value ));
+			}
+			else
+			{
+				throw std::invalid_argument( arg );
+			}
+		}
+		catch( const std::logic_error& )
+		{
+			std::wstringstream ss;
+			ss << L"Bad command line argument [" << wideArg << L"]";
+			throw Exception( _CRT_WIDE( __FILE__ ),__LINE__,ss.str() );
+		}
+	}
+}
+
+void MainWindow::ShowMessageBox( const std::wstring& title,const std::wstring& message ) const
+{
+	std::wcerr << title << L": " << message << std::endl;
+}
+
+bool MainWindow::ProcessMessage()
+{
+	// the toggles go in one per frame, the key buffer only holds a few events
+	if( frameCount < keys.size() )
+	{
+		const unsigned char code = (unsigned char)(std::toupper( (unsigned char)(keys[frameCount]) ));
+		kbd.OnKeyPressed( code );
+		kbd.OnKeyReleased( code );
+	}
+	if( killed || (frameLimit != 0u && frameCount >= frameLimit) )
+	{
+		return false;
+	}
+	frameCount++;
+	return true;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Graphics.h"
+#include "Keyboard.h"
+#include "Mouse.h"
+#include "ChiliException.h"
+#include <string>
+
+// CHILI_HEADLESS stand-in for the win32 window (MainWindow.h includes this one instead)
+// there are no messages to pump: ProcessMessage just counts off frames, the keys asked for on the
+// command line are pressed one per frame from the first, and Graphics gets the frame dump settings
+// command line: [--frames=N] [--keys=TGM] [--dump=path/prefix] [--every=N] [--model=file.obj] [--check-binning]
+// (frames defaults to 600, 0 runs until killed, keys are the Game toggles,
+//  with a model main runs a ModelScene of it instead of the Game,
+//  --check-binning runs the BinningCheck instead and exits with 1 if it fails)
+
+// for granting special access to the dump settings only for Graphics constructor
+class HWNDKey
+{
+	friend Graphics::Graphics( HWNDKey& );
+public:
+	HWNDKey( const HWNDKey& ) = delete;
+	HWNDKey& operator=( HWNDKey& ) = delete;
+protected:
+	HWNDKey() = default;
+protected:
+	std::wstring dumpPath;
+	unsigned int dumpInterval = 1u;
+};
+
+class MainWindow : public HWNDKey
+{
+public:
+	class Exception : public ChiliException
+	{
+	public:
+		using ChiliException::ChiliException;
+		virtual std::wstring GetFullMessage() const override { return GetNote() + L"\nAt: " + GetLocation(); }
+		virtual std::wstring GetExceptionType() const override { return L"Headless Window Exception"; }
+	};
+public:
+	MainWindow( int argc,char* argv[] );
+	MainWindow( const MainWindow& ) = delete;
+	MainWindow& operator=( const MainWindow& ) = delete;
+	bool IsActive() const
+	{
+		return true;
+	}
+	bool IsMinimized() const
+	{
+		return false;
+	}
+	// nobody to show a box to, goes to stderr
+	void ShowMessageBox( const std::wstring& title,const std::wstring& message ) const;
+	void Kill()
+	{
+		killed = true;
+	}
+	// returns false if quitting (killed or all frames run)
+	bool ProcessMessage();
+	const std::wstring& GetArgs() const
+	{
+		return args;
+	}
+	unsigned int GetFrameCount() const
+	{
+		return frameCount;
+	}
+	// empty if none was asked for
+	const std::wstring& GetModelFilename() const
+	{
+		return modelFilename;
+	}
+	bool IsBinningCheck() const
+	{
+		return binningCheck;
+	}
+public:
+	Keyboard kbd;
+	Mouse mouse;
+private:
+	std::wstring args;
+	std::string keys;
+	std::wstring modelFilename;
+	unsigned int frameLimit = 600u;
+	unsigned int frameCount = 0u;
+	bool killed = false;
+	bool binningCheck = false;
+};
\ No newline at end of file
@@ -1,16 +1,113 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <type_traits>
+#include <limits>
+#include <cstdint>
+#include <assert.h>
 #include "Vec3.h"
-#include <fstream>
-#include <cctype>
+#include "ObjFile.h"
+#include "MeshOptimizer.h"
 
+// non-owning view of a contiguous array, just enough of a container for the pipeline
 template<class T>
+class ArrayView
+{
+public:
+	ArrayView() = default;
+	ArrayView( const T* pData,size_t count )
+		:
+		pData( pData ),
+		count( count )
+	{}
+	ArrayView( const std::vector<T>& v )
+		:
+		ArrayView( v.data(),v.size() )
+	{}
+	const T* begin() const
+	{
+		return pData;
+	}
+	const T* end() const
+	{
+		return pData + count;
+	}
+	const T* data() const
+	{
+		return pData;
+	}
+	size_t size() const
+	{
+		return count;
+	}
+	const T& operator[]( size_t i ) const
+	{
+		return pData[i];
+	}
+private:
+	const T* pData = nullptr;
+	size_t count = 0;
+};
+
+template<class T,class Index>
+class IndexedTriangleList;
+
+// what the pipeline draws from: vertex and index arrays owned by someone else
+// (an IndexedTriangleList, or a mapped mesh cache file, see MeshCache.h)
+template<class T,class I = uint32_t>
+class TriangleListView
+{
+public:
+	typedef T Vertex;
+	typedef I Index;
+public:
+	TriangleListView() = default;
+	TriangleListView( ArrayView<T> vertices,ArrayView<I> indices )
+		:
+		vertices( vertices ),
+		indices( indices )
+	{}
+	TriangleListView( const IndexedTriangleList<T,I>& list )
+		:
+		vertices( list.vertices ),
+		indices( list.indices )
+	{}
+	ArrayView<T> vertices;
+	ArrayView<I> indices;
+};
+
+// vertex list plus triangle list of indices into it
+// Index is the unsigned integer type of the indices, uint16_t halves the index memory
+// (and the memory triangle assembly walks through) for models of at most 65536 vertices
+template<class T,class I = uint32_t>
 class IndexedTriangleList
 {
+public:
+	typedef T Vertex;
+	typedef I Index;
+	static_assert(std::is_unsigned<I>::value,"indices have to be unsigned integers");
+private:
+	// vertex members filled from the obj when the vertex type has them
+	template<class V,class = void>
+	struct HasNormal : std::false_type
+	{};
+	template<class V>
+	struct HasNormal<V,std::void_t<decltype(std::declval<V&>().n)>> : std::true_type
+	{};
+	template<class V,class = void>
+	struct HasTexcoord : std::false_type
+	{};
+	template<class V>
+	struct HasTexcoord<V,std::void_t<decltype(std::declval<V&>().uv)>> : std::true_type
+	{};
+public:
+	// obj attributes that end up in T (see Load)
+	static constexpr bool hasNormal = HasNormal<T>::value;
+	static constexpr bool hasTexcoord = HasTexcoord<T>::value;
 public:
 	IndexedTriangleList() = default;
-	IndexedTriangleList( std::vector<T> verts_in,std::vector<size_t> indices_in )
+	IndexedTriangleList( std::vector<T> verts_in,std::vector<I> indices_in )
 		:
 		vertices( std::move( verts_in ) ),
 		indices( std::move( indices_in ) )
@@ -18,6 +115,60 @@ public:
 		assert( vertices.size() > 2 );
 		assert( indices.size() % 3 == 0 );
 	}
+	// loads the faces of a wavefront obj file (see ObjFile)
+	// T gets pos and, if it has such members, n (vn records) and uv (vt records)
+	// corners are shared as one vertex when they agree on all the attributes T has,
+	// triangles and vertices are then reordered for the vertex cache and fetch (see MeshOptimizer)
+	// throws ObjFile::Exception if there are more vertices than I can index
+	static IndexedTriangleList Load( const std::wstring& filename )
+	{
+		return FromObj( ObjFile::Load( filename ) );
+	}
+	// same as Load for an already parsed obj
+	static IndexedTriangleList FromObj( const ObjFile& obj )
+	{
+		std::vector<ObjFile::Corner> corners;
+		std::vector<uint32_t> indices;
+		obj.Deduplicate( hasTexcoord,hasNormal,corners,indices );
+		if( corners.size() > size_t( std::numeric_limits<I>::max() ) + 1 )
+		{
+			throw ObjFile::Exception( _CRT_WIDE( __FILE__ ),__LINE__,L"Loading obj: too many vertices for the index type." );
+		}
+
+		IndexedTriangleList list;
+		list.indices.assign( indices.begin(),indices.end() );
+
+		list.vertices.resize( corners.size() );
+		for( size_t i = 0; i < corners.size(); i++ )
+		{
+			const ObjFile::Corner& c = corners[i];
+			T& v = list.vertices[i];
+			v.pos = obj.positions[c.pos];
+			if constexpr( hasNormal )
+			{
+				v.n = c.norm >= 0 ? obj.normals[c.norm] : Vec3{ 0.0f,0.0f,0.0f };
+			}
+			if constexpr( hasTexcoord )
+			{
+				v.uv = c.tex >= 0 ? obj.texcoords[c.tex] : Vec2{ 0.0f,0.0f };
+			}
+		}
+		OptimizeVertexCache( list.indices,list.vertices.size() );
+		OptimizeVertexFetch( list.vertices,list.indices );
+		return list;
+	}
 	std::vector<T> vertices;
-	std::vector<size_t> indices;
-};
\ No newline at end of file
+	std::vector<I> indices;
+};
+
+// views of the things that hold triangle lists, so that the pipeline can take any of them
+template<class T,class I>
+TriangleListView<T,I> MakeTriangleListView( const TriangleListView<T,I>& view )
+{
+	return view;
+}
+template<class T,class I>
+TriangleListView<T,I> MakeTriangleListView( const IndexedTriangleList<T,I>& list )
+{
+	return list;
+}
\ No newline at end of file
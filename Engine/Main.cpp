@@ -22,6 +22,89 @@
 #include "Game.h"
 #include "ChiliException.h"
 
+#ifdef CHILI_HEADLESS
+#include "ModelScene.h"
+#include "BinningCheck.h"
+#include "FrameTimer.h"
+#include <iostream>
+
+// runs the frames asked for on the command line and reports the average frame time
+// (and in debug builds how often the pipelines' scratch storage grew after the first frame: never
+// for a still scene, with moving objects the tile bins keep growing for a while, each tile until
+// it has seen its busiest frame)
+template<class Scene>
+void RunFrames( MainWindow& wnd,Scene& scene )
+{
+	FrameTimer ft;
+#ifndef NDEBUG
+	size_t firstFrameGrowthCount = 0;
+	bool isFirstFrame = true;
+#endif
+	while( wnd.ProcessMessage() )
+	{
+		scene.Go();
+#ifndef NDEBUG
+		if( isFirstFrame )
+		{
+			firstFrameGrowthCount = scene.GetScratchGrowthCount();
+			isFirstFrame = false;
+		}
+#endif
+	}
+	const float seconds = ft.Mark();
+	const unsigned int frames = wnd.GetFrameCount();
+	std::wcout << frames << L" frames in " << seconds << L" s ("
+		<< (frames > 0u ? seconds * 1000.0f / float( frames ) : 0.0f) << L" ms/frame)" << std::endl;
+#ifndef NDEBUG
+	std::wcout << L"scratch storage grew " << firstFrameGrowthCount << L" times in the first frame, "
+		<< scene.GetScratchGrowthCount() - firstFrameGrowthCount << L" times after it" << std::endl;
+#endif
+}
+
+// the game, or a model (--model=) for the 3D path, for profiling without a window (see HeadlessWindow.h)
+// --check-binning compares binned and immediate rasterization instead
+int main( int argc,char* argv[] )
+{
+	try
+	{
+		MainWindow wnd( argc,argv );
+		if( wnd.IsBinningCheck() )
+		{
+			BinningCheck check( wnd );
+			return check.Run() == 0 ? 0 : 1;
+		}
+		if( wnd.GetModelFilename().empty() )
+		{
+			Game theGame( wnd );
+			RunFrames( wnd,theGame );
+		}
+		else
+		{
+			ModelScene scene( wnd,wnd.GetModelFilename() );
+			RunFrames( wnd,scene );
+		}
+	}
+	catch( const ChiliException& e )
+	{
+		std::wcerr << e.GetExceptionType() << L": " << e.GetFullMessage() << std::endl;
+		return 1;
+	}
+	catch( const std::exception& e )
+	{
+		// need to convert std::exception what() string from narrow to wide string
+		const std::string whatStr( e.what() );
+		std::wcerr << L"Unhandled STL Exception: " << std::wstring( whatStr.begin(),whatStr.end() ) << std::endl;
+		return 1;
+	}
+	catch( ... )
+	{
+		std::wcerr << L"Unhandled Non-STL Exception" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+#else
 int WINAPI wWinMain( HINSTANCE hInst,HINSTANCE,LPWSTR pArgs,INT )
 {
 	try
@@ -76,4 +159,5 @@ int WINAPI wWinMain( HINSTANCE hInst,HINSTANCE,LPWSTR pArgs,INT )
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -19,6 +19,7 @@
 *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
 ******************************************************************************************/
 #include "MainWindow.h"
+#ifndef CHILI_HEADLESS
 #include "Resource.h"
 #include "Graphics.h"
 #include "ChiliException.h"
@@ -225,4 +226,5 @@ LRESULT MainWindow::HandleMsg( HWND hWnd,UINT msg,WPARAM wParam,LPARAM lParam )
 	}
 
 	return DefWindowProc( hWnd,msg,wParam,lParam );
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -20,6 +20,10 @@
 ******************************************************************************************/
 #pragma once
 #include "ChiliWin.h"
+#ifdef CHILI_HEADLESS
+// same interface without a window
+#include "HeadlessWindow.h"
+#else
 #include "Graphics.h"
 #include "Keyboard.h"
 #include "Mouse.h"
@@ -78,4 +82,5 @@ private:
 	static constexpr wchar_t* wndClassName = L"Chili DirectX Framework Window";
 	HINSTANCE hInst = nullptr;
 	std::wstring args;
-};
\ No newline at end of file
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "MappedFile.h"
+#include <sstream>
+#include <utility>
+
+#ifdef _WIN32
+#define FULL_WINTARD
+#include "ChiliWin.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	MappedFile::Exception MakeException( const wchar_t* file,unsigned int line,const std::wstring& filename,const wchar_t* what )
+	{
+		std::wstringstream ss;
+		ss << L"Mapping file [" << filename << L"]: " << what;
+		return MappedFile::Exception( file,line,ss.str() );
+	}
+#ifndef _WIN32
+	// posix paths are byte strings, encode as utf-8
+	std::string ToUtf8( const std::wstring& s )
+	{
+		std::string out;
+		out.reserve( s.size() );
+		for( const wchar_t wc : s )
+		{
+			const unsigned long c = (unsigned long)wc;
+			if( c < 0x80 )
+			{
+				out += char( c );
+			}
+			else if( c < 0x800 )
+			{
+				out += char( 0xC0 | (c >> 6) );
+				out += char( 0x80 | (c & 0x3F) );
+			}
+			else if( c < 0x10000 )
+			{
+				out += char( 0xE0 | (c >> 12) );
+				out += char( 0x80 | ((c >> 6) & 0x3F) );
+				out += char( 0x80 | (c & 0x3F) );
+			}
+			else
+			{
+				out += char( 0xF0 | (c >> 18) );
+				out += char( 0x80 | ((c >> 12) & 0x3F) );
+				out += char( 0x80 | ((c >> 6) & 0x3F) );
+				out += char( 0x80 | (c & 0x3F) );
+			}
+		}
+		return out;
+	}
+#endif
+}
+
+MappedFile::MappedFile( const std::wstring& filename )
+{
+#ifdef _WIN32
+	const HANDLE hFile = CreateFileW( filename.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,
+		OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,nullptr );
+	if( hFile == INVALID_HANDLE_VALUE )
+	{
+		throw MakeException( _CRT_WIDE( __FILE__ ),__LINE__,filename,L"failed to open." );
+	}
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx( hFile,&fileSize ) )
+	{
+		CloseHandle( hFile );
+		throw MakeException( _CRT_WIDE( __FILE__ ),__LINE__,filename,L"failed to get size." );
+	}
+	size = size_t( fileSize.QuadPart );
+	// empty files can't be mapped, they just have no data
+	if( size != 0 )
+	{
+		const HANDLE hMapping = CreateFileMappingW( hFile,nullptr,PAGE_READONLY,0,0,nullptr );
+		if( hMapping != nullptr )
+		{
+			pData = static_cast<const char*>(MapViewOfFile( hMapping,FILE_MAP_READ,0,0,0 ));
+			CloseHandle( hMapping );
+		}
+	}
+	CloseHandle( hFile );
+#else
+	const int fd = open( ToUtf8( filename ).c_str(),O_RDONLY );
+	if( fd == -1 )
+	{
+		throw MakeException( _CRT_WIDE( __FILE__ ),__LINE__,filename,L"failed to open." );
+	}
+	struct stat st;
+	if( fstat( fd,&st ) != 0 )
+	{
+		close( fd );
+		throw MakeException( _CRT_WIDE( __FILE__ ),__LINE__,filename,L"failed to get size." );
+	}
+	size = size_t( st.st_size );
+	if( size != 0 )
+	{
+		void* p = mmap( nullptr,size,PROT_READ,MAP_PRIVATE,fd,0 );
+		if( p != MAP_FAILED )
+		{
+			// whole file gets read front to back
+			madvise( p,size,MADV_SEQUENTIAL );
+			pData = static_cast<const char*>(p);
+		}
+	}
+	close( fd );
+#endif
+	if( size != 0 && pData == nullptr )
+	{
+		throw MakeException( _CRT_WIDE( __FILE__ ),__LINE__,filename,L"failed to map." );
+	}
+}
+
+MappedFile::MappedFile( MappedFile&& donor ) noexcept
+	:
+	pData( std::exchange( donor.pData,nullptr ) ),
+	size( std::exchange( donor.size,0 ) )
+{}
+
+MappedFile& MappedFile::operator=( MappedFile&& rhs ) noexcept
+{
+	if( this != &rhs )
+	{
+		Release();
+		pData = std::exchange( rhs.pData,nullptr );
+		size = std::exchange( rhs.size,0 );
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	Release();
+}
+
+void MappedFile::Release()
+{
+	if( pData != nullptr )
+	{
+#ifdef _WIN32
+		UnmapViewOfFile( pData );
+#else
+		munmap( const_cast<char*>(pData),size );
+#endif
+		pData = nullptr;
+		size = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ChiliException.h"
+#include <string>
+#include <cstddef>
+
+// read-only memory mapping of a whole file
+// the contents are paged in by the os on first touch, nothing is copied into the process
+// (file and mapping handles are closed right away, the view alone keeps the mapping alive)
+class MappedFile
+{
+public:
+	class Exception : public ChiliException
+	{
+	public:
+		using ChiliException::ChiliException;
+		virtual std::wstring GetFullMessage() const override { return GetNote() + L"\nAt: " + GetLocation(); }
+		virtual std::wstring GetExceptionType() const override { return L"Mapped File Exception"; }
+	};
+public:
+	MappedFile( const std::wstring& filename );
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+	MappedFile( MappedFile&& donor ) noexcept;
+	MappedFile& operator=( MappedFile&& rhs ) noexcept;
+	~MappedFile();
+	// contents of the file (not null terminated), nullptr for an empty file
+	const char* GetData() const
+	{
+		return pData;
+	}
+	size_t GetSize() const
+	{
+		return size;
+	}
+	const char* begin() const
+	{
+		return pData;
+	}
+	const char* end() const
+	{
+		return pData + size;
+	}
+private:
+	void Release();
+private:
+	const char* pData = nullptr;
+	size_t size = 0;
+};
\ No newline at end of file
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "Vec2.h"
+#include <cstring>
 
 template <typename T>
 class _Mat2
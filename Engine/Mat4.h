@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Vec4.h"
+#include "Mat3.h"
+
+// 4x4 matrix for homogeneous transforms, row vector convention like Mat3 (v' = v * M)
+// so a * b applies a first and then b
+template <typename T>
+class _Mat4
+{
+public:
+	_Mat4& operator*=( const _Mat4& rhs )
+	{
+		return *this = *this * rhs;
+	}
+	_Mat4 operator*( const _Mat4& rhs ) const
+	{
+		_Mat4 result;
+		for( size_t j = 0; j < 4; j++ )
+		{
+			for( size_t k = 0; k < 4; k++ )
+			{
+				T sum = (T)0.0;
+				for( size_t i = 0; i < 4; i++ )
+				{
+					sum += elements[j][i] * rhs.elements[i][k];
+				}
+				result.elements[j][k] = sum;
+			}
+		}
+		return result;
+	}
+	static _Mat4 Identity()
+	{
+		return{
+			(T)1.0,(T)0.0,(T)0.0,(T)0.0,
+			(T)0.0,(T)1.0,(T)0.0,(T)0.0,
+			(T)0.0,(T)0.0,(T)1.0,(T)0.0,
+			(T)0.0,(T)0.0,(T)0.0,(T)1.0
+		};
+	}
+	static _Mat4 Scaling( T factor )
+	{
+		return{
+			factor,(T)0.0,(T)0.0,(T)0.0,
+			(T)0.0,factor,(T)0.0,(T)0.0,
+			(T)0.0,(T)0.0,factor,(T)0.0,
+			(T)0.0,(T)0.0,(T)0.0,(T)1.0
+		};
+	}
+	static _Mat4 Translation( T x,T y,T z )
+	{
+		return{
+			(T)1.0,(T)0.0,(T)0.0,(T)0.0,
+			(T)0.0,(T)1.0,(T)0.0,(T)0.0,
+			(T)0.0,(T)0.0,(T)1.0,(T)0.0,
+			x,     y,     z,     (T)1.0
+		};
+	}
+	// embeds a 3x3 linear transform (rotation, scale)
+	static _Mat4 FromMat3( const _Mat3<T>& m )
+	{
+		return{
+			m.elements[0][0],m.elements[0][1],m.elements[0][2],(T)0.0,
+			m.elements[1][0],m.elements[1][1],m.elements[1][2],(T)0.0,
+			m.elements[2][0],m.elements[2][1],m.elements[2][2],(T)0.0,
+			(T)0.0,          (T)0.0,          (T)0.0,          (T)1.0
+		};
+	}
+	static _Mat4 RotationX( T theta )
+	{
+		return FromMat3( _Mat3<T>::RotationX( theta ) );
+	}
+	static _Mat4 RotationY( T theta )
+	{
+		return FromMat3( _Mat3<T>::RotationY( theta ) );
+	}
+	static _Mat4 RotationZ( T theta )
+	{
+		return FromMat3( _Mat3<T>::RotationZ( theta ) );
+	}
+	// perspective projection from view space (x right, y up, looking down +z)
+	// to clip space, horizontal field of view in radians and aspect ratio width / height
+	// visible volume after the divide is x,y in -1 ~ 1 and z in 0 (near) ~ 1 (far), w is view space z
+	static _Mat4 ProjectionHFOV( T fov,T aspect,T nearZ,T farZ )
+	{
+		const T xScale = (T)1.0 / tan( fov / (T)2.0 );
+		const T yScale = xScale * aspect;
+		const T zScale = farZ / (farZ - nearZ);
+		return{
+			xScale,(T)0.0,(T)0.0,          (T)0.0,
+			(T)0.0,yScale,(T)0.0,          (T)0.0,
+			(T)0.0,(T)0.0,zScale,          (T)1.0,
+			(T)0.0,(T)0.0,-nearZ * zScale, (T)0.0
+		};
+	}
+public:
+	// [ row ][ col ]
+	T elements[4][4];
+};
+
+template<typename T>
+_Vec4<T>& operator*=( _Vec4<T>& lhs,const _Mat4<T>& rhs )
+{
+	return lhs = lhs * rhs;
+}
+
+template<typename T>
+_Vec4<T> operator*( const _Vec4<T>& lhs,const _Mat4<T>& rhs )
+{
+	return{
+		lhs.x * rhs.elements[0][0] + lhs.y * rhs.elements[1][0] + lhs.z * rhs.elements[2][0] + lhs.w * rhs.elements[3][0],
+		lhs.x * rhs.elements[0][1] + lhs.y * rhs.elements[1][1] + lhs.z * rhs.elements[2][1] + lhs.w * rhs.elements[3][1],
+		lhs.x * rhs.elements[0][2] + lhs.y * rhs.elements[1][2] + lhs.z * rhs.elements[2][2] + lhs.w * rhs.elements[3][2],
+		lhs.x * rhs.elements[0][3] + lhs.y * rhs.elements[1][3] + lhs.z * rhs.elements[2][3] + lhs.w * rhs.elements[3][3]
+	};
+}
+
+typedef _Mat4<float> Mat4;
+typedef _Mat4<double> Mad4;
\ No newline at end of file
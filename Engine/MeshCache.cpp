@@ -0,0 +1,143 @@
+#include "MeshCache.h"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <algorithm>
+
+uint64_t MeshCache::Hash( const char* pData,size_t size )
+{
+	// multiply-xorshift over 8 byte words, seeded with the size
+	constexpr uint64_t prime = 0x9E3779B97F4A7C15ull;
+	uint64_t h = size * prime;
+	const auto mix = [&h]( uint64_t word )
+	{
+		h = (h ^ word) * prime;
+		h ^= h >> 29;
+	};
+	size_t i = 0;
+	for( ; i + 8 <= size; i += 8 )
+	{
+		uint64_t word;
+		memcpy( &word,pData + i,8 );
+		mix( word );
+	}
+	if( i < size )
+	{
+		uint64_t word = 0;
+		memcpy( &word,pData + i,size - i );
+		mix( word );
+	}
+	return h ^ (h >> 32);
+}
+
+namespace
+{
+	template<class I>
+	bool IndicesInRange( const I* pIndices,uint64_t indexCount,uint64_t vertexCount )
+	{
+		// largest index, no early out so the loop stays branch free
+		uint64_t maxIndex = 0;
+		for( uint64_t i = 0; i < indexCount; i++ )
+		{
+			maxIndex = std::max( maxIndex,uint64_t( pIndices[i] ) );
+		}
+		return indexCount == 0 || maxIndex < vertexCount;
+	}
+}
+
+const MeshCache::Header* MeshCache::Validate( const MappedFile& cache,const Header& expected )
+{
+	if( cache.GetSize() < sizeof( Header ) )
+	{
+		return nullptr;
+	}
+	const Header* pHeader = reinterpret_cast<const Header*>(cache.GetData());
+	if( memcmp( pHeader->magic,expected.magic,sizeof( magic ) ) != 0 ||
+		pHeader->version != expected.version ||
+		pHeader->sourceSize != expected.sourceSize ||
+		pHeader->sourceHash != expected.sourceHash ||
+		pHeader->vertexSize != expected.vertexSize ||
+		pHeader->vertexAttributes != expected.vertexAttributes ||
+		pHeader->indexSize != expected.indexSize )
+	{
+		return nullptr;
+	}
+	// arrays have to be aligned and inside the file (counts compared against what fits, the byte
+	// sizes of counts from a broken header could overflow)
+	const uint64_t fileSize = cache.GetSize();
+	if( pHeader->vertexOffset % alignment != 0 || pHeader->indexOffset % alignment != 0 ||
+		pHeader->vertexOffset < sizeof( Header ) || pHeader->vertexOffset > fileSize ||
+		pHeader->indexOffset > fileSize ||
+		pHeader->vertexCount > (fileSize - pHeader->vertexOffset) / pHeader->vertexSize ||
+		pHeader->indexCount > (fileSize - pHeader->indexOffset) / pHeader->indexSize ||
+		pHeader->indexCount % 3 != 0 )
+	{
+		return nullptr;
+	}
+	// and every index has to name a vertex, once here so that drawing never has to check
+	const char* const pIndices = cache.GetData() + pHeader->indexOffset;
+	bool inRange = false;
+	switch( pHeader->indexSize )
+	{
+	case 1:
+		inRange = IndicesInRange( reinterpret_cast<const uint8_t*>(pIndices),pHeader->indexCount,pHeader->vertexCount );
+		break;
+	case 2:
+		inRange = IndicesInRange( reinterpret_cast<const uint16_t*>(pIndices),pHeader->indexCount,pHeader->vertexCount );
+		break;
+	case 4:
+		inRange = IndicesInRange( reinterpret_cast<const uint32_t*>(pIndices),pHeader->indexCount,pHeader->vertexCount );
+		break;
+	case 8:
+		inRange = IndicesInRange( reinterpret_cast<const uint64_t*>(pIndices),pHeader->indexCount,pHeader->vertexCount );
+		break;
+	}
+	return inRange ? pHeader : nullptr;
+}
+
+bool MeshCache::Write( const std::wstring& filename,Header& header,const void* pVertices,const void* pIndices )
+{
+	const auto align = []( uint64_t offset )
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	};
+	const uint64_t vertexBytes = header.vertexCount * header.vertexSize;
+	const uint64_t indexBytes = header.indexCount * header.indexSize;
+	header.vertexOffset = align( sizeof( Header ) );
+	header.indexOffset = align( header.vertexOffset + vertexBytes );
+
+	const std::filesystem::path path( filename );
+	std::filesystem::path tempPath = path;
+	tempPath += L".tmp";
+	{
+		std::ofstream file( tempPath,std::ios::binary | std::ios::trunc );
+		if( !file )
+		{
+			return false;
+		}
+		const char padding[alignment] = {};
+		const auto writePadded = [&]( const void* pData,uint64_t size,uint64_t padSize )
+		{
+			file.write( static_cast<const char*>(pData),std::streamsize( size ) );
+			file.write( padding,std::streamsize( padSize ) );
+		};
+		writePadded( &header,sizeof( Header ),header.vertexOffset - sizeof( Header ) );
+		writePadded( pVertices,vertexBytes,header.indexOffset - header.vertexOffset - vertexBytes );
+		file.write( static_cast<const char*>(pIndices),std::streamsize( indexBytes ) );
+		if( !file )
+		{
+			file.close();
+			std::error_code ec;
+			std::filesystem::remove( tempPath,ec );
+			return false;
+		}
+	}
+	std::error_code ec;
+	std::filesystem::rename( tempPath,path,ec );
+	if( ec )
+	{
+		std::filesystem::remove( tempPath,ec );
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
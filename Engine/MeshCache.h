@@ -0,0 +1,146 @@
+#pragma once
+
+#include "IndexedTriangleList.h"
+#include "MappedFile.h"
+#include "ObjFile.h"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <optional>
+#include <algorithm>
+
+// binary cache of a loaded obj: the vertex and index arrays exactly as they sit in memory
+// laid out as header | vertices | indices, arrays aligned to alignment bytes from the file start
+// (mappings are page aligned, so the arrays can be used in place)
+// a cache is only valid for the obj it was made from (size and content hash) and for the exact
+// same format version, vertex layout and index width, anything else is rebuilt from the obj
+class MeshCache
+{
+public:
+	static constexpr char magic[4] = { 'C','M','S','H' };
+	static constexpr uint32_t version = 2;
+	static constexpr uint64_t alignment = 64;
+	class Header
+	{
+	public:
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceSize;
+		uint64_t sourceHash;
+		uint32_t vertexSize;
+		// which obj attributes are in the vertex, bit 0: normal, bit 1: texcoord
+		uint32_t vertexAttributes;
+		uint32_t indexSize;
+		uint32_t reserved;
+		uint64_t vertexCount;
+		uint64_t indexCount;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+	};
+public:
+	// cache file that goes with an obj
+	static std::wstring GetCacheName( const std::wstring& objFilename )
+	{
+		return objFilename + L".mesh";
+	}
+	// 64-bit hash of the source contents, 8 bytes per step (not cryptographic)
+	static uint64_t Hash( const char* pData,size_t size );
+	// header of a mapped cache if it is intact and matches expected in everything but the offsets
+	// (and the counts, whose arrays have to fit in the file and whose indices all have to be in range)
+	static const Header* Validate( const MappedFile& cache,const Header& expected );
+	// fills in the offsets of header and writes the cache (through a temporary file,
+	// so a crash never leaves a half written cache behind), false if that failed
+	static bool Write( const std::wstring& filename,Header& header,const void* pVertices,const void* pIndices );
+	template<class T,class I>
+	static Header MakeHeader( uint64_t sourceSize,uint64_t sourceHash,size_t vertexCount,size_t indexCount )
+	{
+		Header h = {};
+		std::copy( std::begin( magic ),std::end( magic ),h.magic );
+		h.version = version;
+		h.sourceSize = sourceSize;
+		h.sourceHash = sourceHash;
+		h.vertexSize = uint32_t( sizeof( T ) );
+		h.vertexAttributes = (IndexedTriangleList<T>::hasNormal ? 1u : 0u) | (IndexedTriangleList<T>::hasTexcoord ? 2u : 0u);
+		h.indexSize = uint32_t( sizeof( I ) );
+		h.vertexCount = vertexCount;
+		h.indexCount = indexCount;
+		return h;
+	}
+};
+
+// obj model loaded through its mesh cache
+// when the cache is up to date the arrays are viewed straight out of the mapped cache file,
+// with no parsing and no copying, otherwise the obj is parsed and the cache (re)written
+// if the cache can't be written the parsed list is kept in memory instead
+template<class T,class I = uint32_t>
+class CachedTriangleList
+{
+	static_assert(std::is_trivially_copyable<T>::value,"cached vertices are stored as raw bytes");
+public:
+	static CachedTriangleList Load( const std::wstring& objFilename )
+	{
+		CachedTriangleList result;
+		const MappedFile source( objFilename );
+		const uint64_t hash = MeshCache::Hash( source.GetData(),source.GetSize() );
+		const std::wstring cacheName = MeshCache::GetCacheName( objFilename );
+
+		if( result.MapCache( cacheName,source.GetSize(),hash ) )
+		{
+			return result;
+		}
+
+		IndexedTriangleList<T,I> list = IndexedTriangleList<T,I>::FromObj(
+			ObjFile::Parse( source.begin(),source.end(),objFilename ) );
+		MeshCache::Header header = MeshCache::MakeHeader<T,I>( source.GetSize(),hash,list.vertices.size(),list.indices.size() );
+		if( MeshCache::Write( cacheName,header,list.vertices.data(),list.indices.data() ) &&
+			result.MapCache( cacheName,source.GetSize(),hash ) )
+		{
+			return result;
+		}
+		result.fallback = std::move( list );
+		result.view = *result.fallback;
+		return result;
+	}
+	// true if the arrays are viewed from the cache file
+	bool IsMapped() const
+	{
+		return !fallback;
+	}
+	const TriangleListView<T,I>& GetView() const
+	{
+		return view;
+	}
+private:
+	bool MapCache( const std::wstring& cacheName,uint64_t sourceSize,uint64_t hash )
+	{
+		try
+		{
+			MappedFile cache( cacheName );
+			const MeshCache::Header* pHeader = MeshCache::Validate( cache,MeshCache::MakeHeader<T,I>( sourceSize,hash,0,0 ) );
+			if( !pHeader )
+			{
+				return false;
+			}
+			view = {
+				{ reinterpret_cast<const T*>(cache.GetData() + pHeader->vertexOffset),size_t( pHeader->vertexCount ) },
+				{ reinterpret_cast<const I*>(cache.GetData() + pHeader->indexOffset),size_t( pHeader->indexCount ) } };
+			file = std::move( cache );
+			return true;
+		}
+		catch( const MappedFile::Exception& )
+		{
+			// no cache yet
+			return false;
+		}
+	}
+private:
+	std::optional<MappedFile> file;
+	std::optional<IndexedTriangleList<T,I>> fallback;
+	TriangleListView<T,I> view;
+};
+
+template<class T,class I>
+TriangleListView<T,I> MakeTriangleListView( const CachedTriangleList<T,I>& list )
+{
+	return list.GetView();
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+// index buffer reordering for locality, applied to models at load time
+//   OptimizeVertexCache: triangle order (Tom Forsyth's linear-speed vertex cache optimisation),
+//     triangles that reuse recently used vertices go next, so consecutive triangles share vertices
+//   OptimizeVertexFetch: vertex order, vertices renumbered in the order the triangles first use them,
+//     so both the vertex shader output and the index walk move forward through memory
+// together they keep triangle assembly's vertex lookups within a small, mostly cached window
+
+namespace MeshOptimizerDetail
+{
+	// size of the modelled lru cache
+	constexpr int cacheSize = 32;
+	// vertex score tables (Forsyth's constants)
+	class ScoreTables
+	{
+	public:
+		ScoreTables()
+		{
+			constexpr float cacheDecayPower = 1.5f;
+			constexpr float lastTriScore = 0.75f;
+			constexpr float valenceBoostScale = 2.0f;
+			constexpr float valenceBoostPower = 0.5f;
+			for( int i = 0; i < cacheSize; i++ )
+			{
+				// the 3 vertices of the last triangle get a fixed score, so that the next triangle
+				// doesn't simply reuse the same edge over and over
+				cache[i] = i < 3 ? lastTriScore :
+					std::pow( 1.0f - float( i - 3 ) / float( cacheSize - 3 ),cacheDecayPower );
+			}
+			valence[0] = 0.0f;
+			for( int i = 1; i < maxValence; i++ )
+			{
+				// vertices with few triangles left get boosted, to finish them off and not leave lone triangles
+				valence[i] = valenceBoostScale * std::pow( float( i ),-valenceBoostPower );
+			}
+		}
+		float Score( int cachePos,int remaining ) const
+		{
+			if( remaining == 0 )
+			{
+				return -1.0f;
+			}
+			return (cachePos >= 0 ? cache[cachePos] : 0.0f) + valence[std::min( remaining,maxValence - 1 )];
+		}
+	private:
+		static constexpr int maxValence = 64;
+		float cache[cacheSize];
+		float valence[maxValence];
+	};
+}
+
+template<class Index>
+void OptimizeVertexCache( std::vector<Index>& indices,size_t vertexCount )
+{
+	using namespace MeshOptimizerDetail;
+	static const ScoreTables scores;
+
+	const size_t triCount = indices.size() / 3;
+	if( triCount < 2 )
+	{
+		return;
+	}
+
+	// triangles of each vertex (compressed rows), the first remaining[v] of them not emitted yet
+	std::vector<uint32_t> adjacencyStart( vertexCount + 1,0 );
+	for( const Index i : indices )
+	{
+		adjacencyStart[i + 1]++;
+	}
+	for( size_t v = 0; v < vertexCount; v++ )
+	{
+		adjacencyStart[v + 1] += adjacencyStart[v];
+	}
+	std::vector<uint32_t> adjacency( indices.size() );
+	std::vector<int> remaining( vertexCount,0 );
+	for( size_t t = 0; t < triCount; t++ )
+	{
+		for( int k = 0; k < 3; k++ )
+		{
+			const Index v = indices[t * 3 + k];
+			adjacency[adjacencyStart[v] + remaining[v]++] = uint32_t( t );
+		}
+	}
+
+	std::vector<int> cachePos( vertexCount,-1 );
+	std::vector<float> vertexScore( vertexCount );
+	for( size_t v = 0; v < vertexCount; v++ )
+	{
+		vertexScore[v] = scores.Score( -1,remaining[v] );
+	}
+	std::vector<float> triScore( triCount );
+	std::vector<bool> emitted( triCount,false );
+	size_t bestTri = 0;
+	for( size_t t = 0; t < triCount; t++ )
+	{
+		triScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+		if( triScore[t] > triScore[bestTri] )
+		{
+			bestTri = t;
+		}
+	}
+
+	std::vector<Index> output;
+	output.reserve( indices.size() );
+	// lru order, room for the 3 new vertices pushing old ones out
+	Index cache[cacheSize + 3];
+	size_t cacheCount = 0;
+	// where to look for a fresh start when nothing in the cache has triangles left
+	size_t scanPos = 0;
+	for( size_t nEmitted = 0; nEmitted < triCount; nEmitted++ )
+	{
+		const Index* tri = &indices[bestTri * 3];
+		output.insert( output.end(),tri,tri + 3 );
+		emitted[bestTri] = true;
+
+		// take the triangle off its vertices' remaining lists
+		for( int k = 0; k < 3; k++ )
+		{
+			const Index v = tri[k];
+			uint32_t* pBegin = &adjacency[adjacencyStart[v]];
+			uint32_t* pLast = pBegin + --remaining[v];
+			std::iter_swap( std::find( pBegin,pLast,uint32_t( bestTri ) ),pLast );
+		}
+
+		// triangle's vertices move to the front of the cache
+		Index newCache[cacheSize + 3] = { tri[0],tri[1],tri[2] };
+		size_t newCount = 3;
+		for( size_t i = 0; i < cacheCount; i++ )
+		{
+			const Index v = cache[i];
+			if( v != tri[0] && v != tri[1] && v != tri[2] )
+			{
+				newCache[newCount++] = v;
+			}
+		}
+		// rescore everything that was or is in the cache, and the triangles around it
+		for( size_t i = 0; i < newCount; i++ )
+		{
+			const Index v = newCache[i];
+			cachePos[v] = i < size_t( cacheSize ) ? int( i ) : -1;
+			vertexScore[v] = scores.Score( cachePos[v],remaining[v] );
+		}
+		float bestScore = -1.0f;
+		for( size_t i = 0; i < newCount; i++ )
+		{
+			const Index v = newCache[i];
+			for( uint32_t j = adjacencyStart[v],end = adjacencyStart[v] + remaining[v]; j < end; j++ )
+			{
+				const uint32_t t = adjacency[j];
+				triScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+				if( triScore[t] > bestScore )
+				{
+					bestScore = triScore[t];
+					bestTri = t;
+				}
+			}
+		}
+		// counts are unsigned, signed ones made g++ see a negative length copy here (-Wstringop-overflow)
+		cacheCount = std::min( newCount,size_t( cacheSize ) );
+		std::copy_n( newCache,cacheCount,cache );
+
+		// dead end, continue with the next triangle in the original order
+		if( bestScore < 0.0f )
+		{
+			while( scanPos < triCount && emitted[scanPos] )
+			{
+				scanPos++;
+			}
+			bestTri = scanPos;
+		}
+	}
+	indices = std::move( output );
+}
+
+// renumbers vertices in order of first use (dropping unused ones) and rewrites the indices
+template<class Vertex,class Index>
+void OptimizeVertexFetch( std::vector<Vertex>& vertices,std::vector<Index>& indices )
+{
+	constexpr size_t unused = ~size_t( 0 );
+	std::vector<size_t> remap( vertices.size(),unused );
+	std::vector<Vertex> reordered;
+	reordered.reserve( vertices.size() );
+	for( Index& i : indices )
+	{
+		if( remap[i] == unused )
+		{
+			remap[i] = reordered.size();
+			reordered.push_back( vertices[i] );
+		}
+		i = Index( remap[i] );
+	}
+	vertices = std::move( reordered );
+}
\ No newline at end of file
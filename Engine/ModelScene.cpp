@@ -0,0 +1,81 @@
+#include "MainWindow.h"
+#include "ModelScene.h"
+#include <algorithm>
+
+ModelScene::ModelScene( MainWindow& wnd,const std::wstring& modelFilename )
+	:
+	wnd( wnd ),
+	gfx( wnd ),
+	pipeline( gfx ),
+	model( CachedTriangleList<FlatShadeEffect::Vertex>::Load( modelFilename ) )
+{
+	const auto& vertices = model.GetView().vertices;
+	if( vertices.size() > 0 )
+	{
+		Vec3 lo = vertices[0].pos;
+		Vec3 hi = vertices[0].pos;
+		for( const auto& v : vertices )
+		{
+			lo = { std::min( lo.x,v.pos.x ),std::min( lo.y,v.pos.y ),std::min( lo.z,v.pos.z ) };
+			hi = { std::max( hi.x,v.pos.x ),std::max( hi.y,v.pos.y ),std::max( hi.z,v.pos.z ) };
+		}
+		const Vec3 center = (lo + hi) * 0.5f;
+		const float radius = std::max( (hi - lo).Len() * 0.5f,0.0001f );
+		normalize = Mat4::Translation( -center.x,-center.y,-center.z ) * Mat4::Scaling( 1.0f / radius );
+	}
+	pipeline.effect.vs.BindViewProjection( Mat4::ProjectionHFOV( fov,1.0f,0.1f,10.0f ) );
+	pipeline.SetDepthTest( true );
+	pipeline.SetRasterMode( RasterMode::Binned );
+}
+
+void ModelScene::Go()
+{
+	gfx.BeginFrame();
+	UpdateModel();
+	ComposeFrame();
+	gfx.EndFrame();
+}
+
+void ModelScene::UpdateModel()
+{
+	while( !wnd.kbd.KeyIsEmpty() )
+	{
+		const auto e = wnd.kbd.ReadKey();
+		if( e.IsPress() && e.GetCode() == 'B' )
+		{
+			pipeline.SetRasterMode( pipeline.GetRasterMode() == RasterMode::Binned ?
+				RasterMode::Immediate : RasterMode::Binned );
+		}
+		else if( e.IsPress() && e.GetCode() == 'H' )
+		{
+			switch( pipeline.GetRasterCore() )
+			{
+			case RasterCore::Scanline:
+				pipeline.SetRasterCore( RasterCore::HalfSpace );
+				break;
+			case RasterCore::HalfSpace:
+				pipeline.SetRasterCore( RasterCore::FixedPoint );
+				break;
+			default:
+				pipeline.SetRasterCore( RasterCore::Scanline );
+				break;
+			}
+		}
+	}
+#ifdef CHILI_HEADLESS
+	// fixed step, headless frames come as fast as they render
+	const float dt = 1.0f / 60.0f;
+#else
+	const float dt = ft.Mark();
+#endif
+	angle = wrap_angle( angle + spinSpeed * dt );
+}
+
+void ModelScene::ComposeFrame()
+{
+	const FlatShadeEffect::Instance inst = {
+		normalize * Mat4::RotationY( angle ) * Mat4::Translation( 0.0f,0.0f,distance ),
+		Color( 200u,200u,200u ) };
+	pipeline.DrawInstanced( model,&inst,1 );
+	pipeline.Flush();
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Graphics.h"
+#include "FrameTimer.h"
+#include "Pipeline.h"
+#include "FlatShadeEffect.h"
+#include "MeshCache.h"
+#include <string>
+
+// one obj model (through its mesh cache) turning in front of the camera, flat shaded and depth tested
+// the 3D counterpart of Game for benchmarking the perspective path, driven the same way
+// (headless main runs it instead of Game for --model=, see HeadlessWindow.h)
+// keys: B toggles binned/immediate, H cycles the raster cores
+class ModelScene
+{
+public:
+	ModelScene( class MainWindow& wnd,const std::wstring& modelFilename );
+	ModelScene( const ModelScene& ) = delete;
+	ModelScene& operator=( const ModelScene& ) = delete;
+	void Go();
+	// debug builds only, see Pipeline::GetScratchGrowthCount
+	size_t GetScratchGrowthCount() const
+	{
+		return pipeline.GetScratchGrowthCount();
+	}
+private:
+	void ComposeFrame();
+	void UpdateModel();
+private:
+	MainWindow& wnd;
+	Graphics gfx;
+	static constexpr float fov = PI / 2.0f;
+	static constexpr float distance = 2.0f;
+	// radians per second
+	static constexpr float spinSpeed = 1.0f;
+	FrameTimer ft;
+	Pipeline<FlatShadeEffect> pipeline;
+	CachedTriangleList<FlatShadeEffect::Vertex> model;
+	// moves the model's bounding box center to the origin and scales it to unit radius
+	Mat4 normalize = Mat4::Identity();
+	float angle = 0.0f;
+};
\ No newline at end of file
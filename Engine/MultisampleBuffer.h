@@ -0,0 +1,176 @@
+#pragma once
+
+#include "Surface.h"
+#include "Colors.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <assert.h>
+#include <emmintrin.h>
+
+// 4x multisample antialiasing storage for opaque fills
+// pixels that a fill covers on all 4 samples are written straight to the render target as usual,
+// only edge pixels (partly covered by some fill) get a record of 4 sample colors, so the extra
+// storage and the resolve cost scale with the length of the edges, not with the screen area
+// Resolve averages the samples of every record into the render target (before it is presented)
+// rows are split into columns of columnWidth pixels with their own records, so that threads working
+// on tiles of (a multiple of) columnWidth pixels never share them
+class MultisampleBuffer
+{
+public:
+	static constexpr int nSamples = 4;
+	static constexpr unsigned int fullMask = (1u << nSamples) - 1u;
+	static constexpr int columnWidth = 64;
+	// sample positions inside the pixel (rotated grid, no two samples share a row or a column)
+	static constexpr float sampleX[nSamples] = { 0.375f,0.875f,0.125f,0.625f };
+	static constexpr float sampleY[nSamples] = { 0.125f,0.375f,0.625f,0.875f };
+public:
+	MultisampleBuffer( int width,int height )
+		:
+		width( width ),
+		height( height ),
+		nColumns( (width + columnWidth - 1) / columnWidth ),
+		rows( nColumns * height ),
+		pRecordIndices( std::make_unique<unsigned char[]>( width * height ) )
+	{
+		std::fill( pRecordIndices.get(),pRecordIndices.get() + width * height,noRecord );
+	}
+	MultisampleBuffer( const MultisampleBuffer& ) = delete;
+	MultisampleBuffer& operator=( const MultisampleBuffer& ) = delete;
+	// drops all records without resolving them
+	void Clear()
+	{
+		for( int y = 0; y < height; y++ )
+		{
+			for( int col = 0; col < nColumns; col++ )
+			{
+				ClearColumn( y,col );
+			}
+		}
+	}
+	// pixels [xStart,xEnd) of row y got covered on all samples (the caller writes the color to the
+	// render target), edge pixels among them aren't edge pixels anymore
+	void Cover( int xStart,int xEnd,int y )
+	{
+		assert( xStart >= 0 );
+		assert( xEnd <= width );
+		assert( y >= 0 );
+		assert( y < height );
+		for( int col = xStart / columnWidth; xStart < xEnd; col++ )
+		{
+			const int colEnd = std::min( xEnd,(col + 1) * columnWidth );
+			// records are only the current edge pixels, a few per column row,
+			// cheaper to check them than the span's pixels
+			std::vector<Record>& records = rows[y * nColumns + col];
+			for( size_t i = 0; i < records.size(); )
+			{
+				const int x = records[i].x;
+				if( x >= xStart && x < colEnd )
+				{
+					// last record moves into the gap
+					pRecordIndices[y * width + x] = noRecord;
+					if( i + 1 < records.size() )
+					{
+						records[i] = records.back();
+						pRecordIndices[y * width + records[i].x] = (unsigned char)i;
+					}
+					records.pop_back();
+				}
+				else
+				{
+					i++;
+				}
+			}
+			xStart = colEnd;
+		}
+	}
+	// writes c to the samples of pixel x,y whose bits are set in mask
+	// a pixel without a record gets one, its other samples start out as background
+	// (what the render target holds for the pixel)
+	void Write( int x,int y,unsigned int mask,Color c,Color background )
+	{
+		assert( x >= 0 );
+		assert( x < width );
+		assert( y >= 0 );
+		assert( y < height );
+		std::vector<Record>& records = rows[y * nColumns + x / columnWidth];
+		unsigned char& index = pRecordIndices[y * width + x];
+		if( index == noRecord )
+		{
+			// at most one record per pixel of the column, always fits the index
+			index = (unsigned char)records.size();
+			records.push_back( { { background,background,background,background },x } );
+		}
+		// expand the mask bits to lane masks and merge c into the masked samples
+		const __m128i laneBits = _mm_setr_epi32( 1,2,4,8 );
+		const __m128i laneMask = _mm_cmpeq_epi32( _mm_and_si128( _mm_set1_epi32( int( mask ) ),laneBits ),laneBits );
+		__m128i* const pSamples = reinterpret_cast<__m128i*>(records[index].samples);
+		_mm_store_si128( pSamples,_mm_or_si128(
+			_mm_and_si128( laneMask,_mm_set1_epi32( int( c.dword ) ) ),
+			_mm_andnot_si128( laneMask,_mm_load_si128( pSamples ) ) ) );
+	}
+	// writes the average of the samples of every edge pixel to target and drops the records
+	void Resolve( Surface& target )
+	{
+		assert( int( target.GetWidth() ) == width );
+		assert( int( target.GetHeight() ) == height );
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16( nSamples / 2 );
+		for( int y = 0; y < height; y++ )
+		{
+			for( int col = 0; col < nColumns; col++ )
+			{
+				for( const Record& r : rows[y * nColumns + col] )
+				{
+					// the 4 samples are one register: widen channels to 16 bits, add the halves
+					// (0+2, 1+3) and then the two pairs, round and shift down to the average
+					const __m128i samples = _mm_load_si128( reinterpret_cast<const __m128i*>(r.samples) );
+					const __m128i pairs = _mm_add_epi16( _mm_unpacklo_epi8( samples,zero ),_mm_unpackhi_epi8( samples,zero ) );
+					const __m128i sum = _mm_add_epi16( pairs,_mm_srli_si128( pairs,8 ) );
+					const __m128i avg = _mm_srli_epi16( _mm_add_epi16( sum,round ),2 );
+					Color c;
+					c.dword = (unsigned int)_mm_cvtsi128_si32( _mm_packus_epi16( avg,avg ) );
+					target.PutPixel( r.x,y,c );
+				}
+				ClearColumn( y,col );
+			}
+		}
+	}
+	int GetWidth() const
+	{
+		return width;
+	}
+	int GetHeight() const
+	{
+		return height;
+	}
+private:
+	// samples of an edge pixel
+	struct alignas(16) Record
+	{
+		Color samples[nSamples];
+		int x;
+	};
+	static constexpr unsigned char noRecord = 0xFF;
+	static_assert(columnWidth < noRecord,"record indices are bytes");
+	static_assert(nSamples == 4,"a record is one SSE register of samples");
+private:
+	// records keep their capacity, so steady state frames don't allocate
+	void ClearColumn( int y,int col )
+	{
+		std::vector<Record>& records = rows[y * nColumns + col];
+		for( const Record& r : records )
+		{
+			pRecordIndices[y * width + r.x] = noRecord;
+		}
+		records.clear();
+	}
+private:
+	int width;
+	int height;
+	int nColumns;
+	// edge pixel records of each row of each column
+	std::vector<std::vector<Record>> rows;
+	// index of the record of each pixel within its column row, noRecord if it has none
+	std::unique_ptr<unsigned char[]> pRecordIndices;
+};
\ No newline at end of file
@@ -0,0 +1,337 @@
+#include "ObjFile.h"
+#include "MappedFile.h"
+#include "WorkerPool.h"
+#include <charconv>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+
+namespace
+{
+	// files are split into at most this many chunks per thread, of at least minChunkSize bytes
+	// (a few chunks per thread even out the uneven cost of v and f lines)
+	constexpr size_t chunksPerThread = 4;
+	constexpr size_t minChunkSize = 64 * 1024;
+	constexpr size_t noError = ~size_t( 0 );
+
+	// face corner as parsed, indices that were relative (negative) in the file are relative
+	// to the chunk's own pools until the chunk's place in the whole file is known
+	class ChunkCorner
+	{
+	public:
+		int idx[3];
+		// bit i set if idx[i] is chunk relative
+		unsigned char relativeMask;
+	};
+	class Chunk
+	{
+	public:
+		std::vector<Vec3> positions;
+		std::vector<Vec2> texcoords;
+		std::vector<Vec3> normals;
+		std::vector<ChunkCorner> corners;
+		// file offset of the first malformed record
+		size_t errorOffset = noError;
+		bool badIndex = false;
+	};
+
+	bool IsBlank( char c )
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+	const char* SkipBlanks( const char* p,const char* e )
+	{
+		while( p != e && IsBlank( *p ) )
+		{
+			p++;
+		}
+		return p;
+	}
+	bool ParseFloat( const char*& p,const char* e,float& out )
+	{
+		p = SkipBlanks( p,e );
+		// from_chars doesn't take an explicit plus sign
+		if( p != e && *p == '+' )
+		{
+			p++;
+		}
+		const auto result = std::from_chars( p,e,out );
+		if( result.ec != std::errc() )
+		{
+			return false;
+		}
+		p = result.ptr;
+		return true;
+	}
+	bool ParseInt( const char*& p,const char* e,int& out )
+	{
+		const auto result = std::from_chars( p,e,out );
+		if( result.ec != std::errc() )
+		{
+			return false;
+		}
+		p = result.ptr;
+		return true;
+	}
+	// v, v/t, v//n or v/t/n, missing fields are left at 0 (obj indices never are 0)
+	bool ParseCorner( const char*& p,const char* e,int( &raw )[3] )
+	{
+		raw[0] = raw[1] = raw[2] = 0;
+		if( !ParseInt( p,e,raw[0] ) )
+		{
+			return false;
+		}
+		if( p != e && *p == '/' )
+		{
+			p++;
+			if( p != e && *p != '/' && !ParseInt( p,e,raw[1] ) )
+			{
+				return false;
+			}
+			if( p != e && *p == '/' )
+			{
+				p++;
+				if( !ParseInt( p,e,raw[2] ) )
+				{
+					return false;
+				}
+			}
+		}
+		return raw[0] != 0 && (p == e || IsBlank( *p ));
+	}
+	bool ParseFace( const char* p,const char* e,Chunk& chunk )
+	{
+		const int counts[3] = {
+			int( chunk.positions.size() ),
+			int( chunk.texcoords.size() ),
+			int( chunk.normals.size() ) };
+		ChunkCorner first;
+		ChunkCorner prev;
+		int n = 0;
+		while( (p = SkipBlanks( p,e )) != e )
+		{
+			int raw[3];
+			if( !ParseCorner( p,e,raw ) )
+			{
+				return false;
+			}
+			ChunkCorner cur = { { -1,-1,-1 },0 };
+			for( int i = 0; i < 3; i++ )
+			{
+				if( raw[i] > 0 )
+				{
+					cur.idx[i] = raw[i] - 1;
+				}
+				else if( raw[i] < 0 )
+				{
+					cur.idx[i] = counts[i] + raw[i];
+					cur.relativeMask |= 1 << i;
+				}
+			}
+			// fan around the first corner
+			if( n >= 2 )
+			{
+				chunk.corners.push_back( first );
+				chunk.corners.push_back( prev );
+				chunk.corners.push_back( cur );
+			}
+			else if( n == 0 )
+			{
+				first = cur;
+			}
+			prev = cur;
+			n++;
+		}
+		return n >= 3;
+	}
+	bool ParseLine( const char* p,const char* e,Chunk& chunk )
+	{
+		if( e - p < 2 )
+		{
+			return true;
+		}
+		if( p[0] == 'v' )
+		{
+			if( IsBlank( p[1] ) )
+			{
+				Vec3 v;
+				p += 1;
+				if( !ParseFloat( p,e,v.x ) || !ParseFloat( p,e,v.y ) || !ParseFloat( p,e,v.z ) )
+				{
+					return false;
+				}
+				chunk.positions.push_back( v );
+			}
+			else if( p[1] == 't' && e - p > 2 && IsBlank( p[2] ) )
+			{
+				// v is optional (1D textures)
+				Vec2 t = { 0.0f,0.0f };
+				p += 2;
+				if( !ParseFloat( p,e,t.x ) )
+				{
+					return false;
+				}
+				if( SkipBlanks( p,e ) != e && !ParseFloat( p,e,t.y ) )
+				{
+					return false;
+				}
+				chunk.texcoords.push_back( t );
+			}
+			else if( p[1] == 'n' && e - p > 2 && IsBlank( p[2] ) )
+			{
+				Vec3 n;
+				p += 2;
+				if( !ParseFloat( p,e,n.x ) || !ParseFloat( p,e,n.y ) || !ParseFloat( p,e,n.z ) )
+				{
+					return false;
+				}
+				chunk.normals.push_back( n );
+			}
+			return true;
+		}
+		if( p[0] == 'f' && IsBlank( p[1] ) )
+		{
+			return ParseFace( p + 1,e,chunk );
+		}
+		// comments, groups, materials, smoothing groups...
+		return true;
+	}
+	void ParseChunk( const char* pFile,const char* pBegin,const char* pEnd,Chunk& chunk )
+	{
+		for( const char* p = pBegin; p < pEnd; )
+		{
+			const char* pEol = static_cast<const char*>(memchr( p,'\n',pEnd - p ));
+			if( pEol == nullptr )
+			{
+				pEol = pEnd;
+			}
+			if( !ParseLine( SkipBlanks( p,pEol ),pEol,chunk ) )
+			{
+				chunk.errorOffset = size_t( p - pFile );
+				return;
+			}
+			p = pEol < pEnd ? pEol + 1 : pEnd;
+		}
+	}
+}
+
+ObjFile ObjFile::Load( const std::wstring& filename )
+{
+	const MappedFile file( filename );
+	return Parse( file.begin(),file.end(),filename );
+}
+
+ObjFile ObjFile::Parse( const char* pBegin,const char* pEnd,const std::wstring& source )
+{
+	WorkerPool& workers = WorkerPool::GetShared();
+	const size_t size = size_t( pEnd - pBegin );
+
+	// chunk boundaries are moved forward to the next line start
+	const size_t nChunks = std::max( std::min( workers.GetThreadCount() * chunksPerThread,size / minChunkSize ),size_t( 1 ) );
+	std::vector<const char*> bounds( nChunks + 1,pEnd );
+	bounds[0] = pBegin;
+	for( size_t i = 1; i < nChunks; i++ )
+	{
+		const char* p = std::max( pBegin + size * i / nChunks,bounds[i - 1] );
+		const char* pEol = static_cast<const char*>(memchr( p,'\n',pEnd - p ));
+		bounds[i] = pEol ? pEol + 1 : pEnd;
+	}
+
+	std::vector<Chunk> chunks( nChunks );
+	workers.Run( nChunks,[&]( size_t i )
+	{
+		ParseChunk( pBegin,bounds[i],bounds[i + 1],chunks[i] );
+	} );
+
+	for( const Chunk& c : chunks )
+	{
+		if( c.errorOffset != noError )
+		{
+			std::wstringstream ss;
+			ss << L"Parsing obj [" << source << L"]: malformed record at byte " << c.errorOffset << L".";
+			throw Exception( _CRT_WIDE( __FILE__ ),__LINE__,ss.str() );
+		}
+	}
+
+	// where each chunk's records go in the merged pools
+	std::vector<Corner> bases( nChunks + 1 );
+	std::vector<size_t> cornerBases( nChunks + 1 );
+	bases[0] = { 0,0,0 };
+	cornerBases[0] = 0;
+	for( size_t i = 0; i < nChunks; i++ )
+	{
+		bases[i + 1].pos = bases[i].pos + int( chunks[i].positions.size() );
+		bases[i + 1].tex = bases[i].tex + int( chunks[i].texcoords.size() );
+		bases[i + 1].norm = bases[i].norm + int( chunks[i].normals.size() );
+		cornerBases[i + 1] = cornerBases[i] + chunks[i].corners.size();
+	}
+	ObjFile obj;
+	obj.positions.resize( bases[nChunks].pos );
+	obj.texcoords.resize( bases[nChunks].tex );
+	obj.normals.resize( bases[nChunks].norm );
+	obj.corners.resize( cornerBases[nChunks] );
+
+	const Corner& totals = bases[nChunks];
+	workers.Run( nChunks,[&]( size_t i )
+	{
+		Chunk& c = chunks[i];
+		std::copy( c.positions.begin(),c.positions.end(),obj.positions.begin() + bases[i].pos );
+		std::copy( c.texcoords.begin(),c.texcoords.end(),obj.texcoords.begin() + bases[i].tex );
+		std::copy( c.normals.begin(),c.normals.end(),obj.normals.begin() + bases[i].norm );
+		const int base[3] = { bases[i].pos,bases[i].tex,bases[i].norm };
+		const int total[3] = { totals.pos,totals.tex,totals.norm };
+		Corner* pOut = &obj.corners[cornerBases[i]];
+		for( const ChunkCorner& cc : c.corners )
+		{
+			int idx[3];
+			for( int f = 0; f < 3; f++ )
+			{
+				idx[f] = (cc.relativeMask & (1 << f)) ? cc.idx[f] + base[f] : cc.idx[f];
+				// only the position is mandatory
+				if( idx[f] >= total[f] || idx[f] < (f == 0 ? 0 : -1) )
+				{
+					c.badIndex = true;
+				}
+			}
+			*pOut++ = { idx[0],idx[1],idx[2] };
+		}
+	} );
+
+	for( const Chunk& c : chunks )
+	{
+		if( c.badIndex )
+		{
+			std::wstringstream ss;
+			ss << L"Parsing obj [" << source << L"]: face index out of range.";
+			throw Exception( _CRT_WIDE( __FILE__ ),__LINE__,ss.str() );
+		}
+	}
+	return obj;
+}
+
+void ObjFile::Deduplicate( bool useTex,bool useNorm,std::vector<Corner>& vertices,std::vector<uint32_t>& indices ) const
+{
+	vertices.clear();
+	indices.clear();
+	indices.reserve( corners.size() );
+	// vertices are chained by position, so a lookup only compares against the few sharing it
+	std::vector<int> firstWithPos( positions.size(),-1 );
+	std::vector<int> nextWithPos;
+	for( const Corner& c : corners )
+	{
+		const Corner key = { c.pos,useTex ? c.tex : -1,useNorm ? c.norm : -1 };
+		int v = firstWithPos[key.pos];
+		while( v != -1 && (vertices[v].tex != key.tex || vertices[v].norm != key.norm) )
+		{
+			v = nextWithPos[v];
+		}
+		if( v == -1 )
+		{
+			v = int( vertices.size() );
+			vertices.push_back( key );
+			nextWithPos.push_back( firstWithPos[key.pos] );
+			firstWithPos[key.pos] = v;
+		}
+		indices.push_back( uint32_t( v ) );
+	}
+}
\ No newline at end of file
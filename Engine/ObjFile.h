@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Vec2.h"
+#include "Vec3.h"
+#include "ChiliException.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// geometry of a wavefront obj file: the v / vt / vn pools and the faces (triangulated as fans)
+// the file is memory mapped and split into chunks of whole lines that are parsed in parallel,
+// everything that is not geometry (groups, materials, smoothing) is skipped
+class ObjFile
+{
+public:
+	class Exception : public ChiliException
+	{
+	public:
+		using ChiliException::ChiliException;
+		virtual std::wstring GetFullMessage() const override { return GetNote() + L"\nAt: " + GetLocation(); }
+		virtual std::wstring GetExceptionType() const override { return L"Obj File Exception"; }
+	};
+	// one face corner, 0-based indices into the pools (-1 when the record has none)
+	class Corner
+	{
+	public:
+		int pos;
+		int tex;
+		int norm;
+	};
+public:
+	static ObjFile Load( const std::wstring& filename );
+	// parses obj text, errors are reported with the byte offset of the bad record
+	// (source is only used to name the text in error messages)
+	static ObjFile Parse( const char* pBegin,const char* pEnd,const std::wstring& source = L"memory" );
+	// merges corners with the same pos (and tex / norm when those are used) into one vertex
+	// outputs the unique corners and the index of the vertex of every corner
+	void Deduplicate( bool useTex,bool useNorm,std::vector<Corner>& vertices,std::vector<uint32_t>& indices ) const;
+public:
+	std::vector<Vec3> positions;
+	std::vector<Vec2> texcoords;
+	std::vector<Vec3> normals;
+	// 3 per triangle
+	std::vector<Corner> corners;
+};
\ No newline at end of file
@@ -6,7 +6,35 @@
 #include "IndexedTriangleList.h"
 #include "PubeScreenTransformer.h"
 #include "Mat3.h"
+#include "Affine2.h"
+#include "Rect.h"
+#include "WorkerPool.h"
+#include "SimdBlock.h"
+#include "EffectTraits.h"
 #include <algorithm>
+#include <type_traits>
+#include <functional>
+#include <assert.h>
+
+// how post-processed triangles get turned into pixels
+//   Immediate: each triangle is rasterized on the calling thread as soon as it is processed
+//   Binned:    triangles are sorted into screen tiles and rasterized tile-parallel on Flush()
+enum class RasterMode
+{
+	Immediate,
+	Binned
+};
+
+// which algorithm turns a screen space triangle into pixels
+//   Scanline:  split into flat top/bottom halves and walk edges scanline by scanline
+//   HalfSpace: evaluate the 3 edge functions over SIMD pixel blocks in the bounding box
+//   FixedPoint: integer edge functions on 24.8 subpixel vertices, exact (watertight) top-left rule
+enum class RasterCore
+{
+	Scanline,
+	HalfSpace,
+	FixedPoint
+};
 
 // triangle drawing pipeline with programable
 // pixel shading stage
@@ -18,35 +46,381 @@ public:
 	typedef typename Effect::Vertex Vertex;
 	typedef typename Effect::VertexShader::Output VSOut;
 	typedef typename Effect::GeometryShader::Output GSOut;
+	typedef typename Effect::PixelShader PixelShader;
+	// side length of the square screen tiles used by the binned rasterizer
+	static constexpr int tileSize = 64;
+	static_assert(!(IsPerspective<Effect>::value && IsAffine2D<Effect>::value),
+		"effect can't be both perspective and 2D affine");
+	static_assert(!(IsPerspective<Effect>::value && HasBatchShading<PixelShader>::value),
+		"batch shading interpolates linearly in screen space, perspective effects need per-pixel shading");
+	static_assert(!IsAlphaBlended<PixelShader>::value || IsConstantShader<PixelShader>::value,
+		"alpha blending is only implemented for constant color shaders");
+	static_assert(tileSize % SpanBuffer::columnWidth == 0,"tiles must not share span buffer columns");
+	static_assert(tileSize % MultisampleBuffer::columnWidth == 0,"tiles must not share multisample buffer columns");
+	// binned workers update the depth range records of the zbuffer tiles they test against
+	static_assert(tileSize % ZBuffer::tileSize == 0,"tiles must not share depth buffer tiles");
+private:
+	// screen space plane of the interpolants over a triangle: at the center of pixel (x,y)
+	// they are origin + dvdx * x + dvdy * y, evaluated at each pixel rather than stepped from
+	// where the span or tile starts, so clipping can't change the result
+	struct AttributePlane
+	{
+		GSOut origin;
+		GSOut dvdx;
+		GSOut dvdy;
+	};
+	// the same plane for the batch shader attributes (see HasBatchShading)
+	struct BatchGradients
+	{
+		float origin[BatchAttributeCount<PixelShader>::value];
+		float dadx[BatchAttributeCount<PixelShader>::value];
+		float dady[BatchAttributeCount<PixelShader>::value];
+		// lane offsets within a block
+		FloatBlock ramp[BatchAttributeCount<PixelShader>::value];
+	};
+	// per-triangle state handed down through the rasterization functions
+	struct RasterContext
+	{
+		const PixelShader& ps;
+		RectI clip;
+		// depth range of the triangle's vertices (for the coarse depth tests)
+		float zMin;
+		float zMax;
+		// only set up for interpolating (or depth tested perspective) shaders on the scanline core
+		AttributePlane plane;
+		// only set up for batch shaders on the scanline core
+		BatchGradients gradients;
+	};
+	// triangle waiting in the bins along with the ps state it was submitted with
+	struct BinnedTriangle
+	{
+		Triangle<GSOut> triangle;
+		PixelShader ps;
+	};
+	// convex screen space quad, vertices in outline order
+	struct Quad
+	{
+		GSOut v[4];
+	};
+	struct BinnedQuad
+	{
+		Quad quad;
+		PixelShader ps;
+	};
+	// bin entries with this bit set index binnedQuads instead of binnedTriangles
+	static constexpr unsigned int quadBinFlag = 0x80000000u;
 public:
-	Pipeline( Graphics& gfx )
+	// binned mode rasterizes tiles on the workers of the given pool
+	Pipeline( Graphics& gfx,WorkerPool& workers = WorkerPool::GetShared() )
 		:
-		gfx( gfx )
+		gfx( gfx ),
+		nTilesX( (int( Graphics::ScreenWidth ) + tileSize - 1) / tileSize ),
+		nTilesY( (int( Graphics::ScreenHeight ) + tileSize - 1) / tileSize ),
+		bins( nTilesX * nTilesY ),
+		workers( workers )
 	{}
-	void Draw( IndexedTriangleList<Vertex>& triList )
+	// models can be anything MakeTriangleListView takes (IndexedTriangleList, TriangleListView,
+	// CachedTriangleList) with any index type
+	template<class Model>
+	void Draw( const Model& triList )
+	{
+		const auto view = ViewOf( triList );
+		ProcessVertices( view.vertices,view.indices );
+	}
+	// draws model once for each of the nInstances instances starting at pInstances
+	// instance state is bound with Effect::BindInstance, vertex shader output goes
+	// to scratch storage that is kept around between draws
+	// effects that can tell from the instance state alone that nothing will be visible
+	// get to skip all vertex work for that instance (see HasInstanceCulling)
+	template<class Model,class Instance>
+	void DrawInstanced( const Model& model_in,const Instance* pInstances,size_t nInstances )
+	{
+		const auto model = ViewOf( model_in );
+		ForEachInstance( pInstances,nInstances,[&]()
+		{
+			ShadeVertices( model.vertices );
+			AssembleTriangles( vsScratch,model.indices );
+		} );
+	}
+	template<class Model,class Instance>
+	void DrawInstanced( const Model& model,const std::vector<Instance>& instances )
+	{
+		DrawInstanced( model,instances.data(),instances.size() );
+	}
+	// instanced draw of a quad model (4 vertices, 2 triangles sharing a diagonal)
+	// every instance is rasterized as one convex quad: the 4 edges are set up once and
+	// each scanline is filled between the edges crossing it, so there is no per-triangle
+	// setup and no diagonal walked twice
+	// only constant color effects take the quad path (others fall back to DrawInstanced),
+	// and the geometry shader is bypassed (it has to be a pass-through)
+	template<class Model,class Instance>
+	void DrawInstancedQuads( const Model& quad_in,const Instance* pInstances,size_t nInstances )
+	{
+		const auto quad = ViewOf( quad_in );
+		if constexpr( !IsConstantShader<PixelShader>::value )
+		{
+			DrawInstanced( quad_in,pInstances,nInstances );
+		}
+		else
+		{
+			static_assert(std::is_same<VSOut,GSOut>::value,"quad path requires a pass-through geometry shader");
+			static_assert(!IsPerspective<Effect>::value,"quad path has no clip space stage");
+			assert( quad.vertices.size() == 4 );
+			assert( quad.indices.size() == 6 );
+
+			// outline order with the same winding as the triangles:
+			// the vertex only in the 2nd triangle goes between the ends of the shared diagonal
+			const auto& idx = quad.indices;
+			size_t outline[4];
+			size_t iExtra = idx[3];
+			for( size_t i = 3; i < 6; i++ )
+			{
+				if( idx[i] != idx[0] && idx[i] != idx[1] && idx[i] != idx[2] )
+				{
+					iExtra = idx[i];
+				}
+			}
+			const auto inSecond = [&idx]( size_t v )
+			{
+				return idx[3] == v || idx[4] == v || idx[5] == v;
+			};
+			for( int i = 0,n = 0; i < 3; i++ )
+			{
+				outline[n++] = idx[i];
+				if( inSecond( idx[i] ) && inSecond( idx[(i + 1) % 3] ) )
+				{
+					outline[n++] = iExtra;
+				}
+			}
+
+			ForEachInstance( pInstances,nInstances,[&]()
+			{
+				const auto vs = BindVertexShader();
+				PostProcessQuadVertices( { {
+					vs( quad.vertices[outline[0]] ),
+					vs( quad.vertices[outline[1]] ),
+					vs( quad.vertices[outline[2]] ),
+					vs( quad.vertices[outline[3]] ) } } );
+			} );
+		}
+	}
+	template<class Model,class Instance>
+	void DrawInstancedQuads( const Model& quad,const std::vector<Instance>& instances )
+	{
+		DrawInstancedQuads( quad,instances.data(),instances.size() );
+	}
+	// rasterizes everything binned since the last flush
+	// (no-op in immediate mode, must be called before the frame is presented in binned mode)
+	void Flush()
+	{
+		if( binnedTriangles.empty() && binnedQuads.empty() )
+		{
+			return;
+		}
+		workers.Run( bins.size(),[this]( size_t iTile )
+		{
+			RasterizeTile( int( iTile ) );
+		} );
+		for( auto& bin : bins )
+		{
+			bin.clear();
+		}
+		binnedTriangles.clear();
+		binnedQuads.clear();
+	}
+	void SetRasterMode( RasterMode mode )
+	{
+		// don't leave anything stranded in the bins when switching
+		Flush();
+		rasterMode = mode;
+	}
+	RasterMode GetRasterMode() const
+	{
+		return rasterMode;
+	}
+	void SetRasterCore( RasterCore core )
+	{
+		// binned triangles are rasterized with whatever core is set at flush time
+		Flush();
+		rasterCore = core;
+	}
+	RasterCore GetRasterCore() const
+	{
+		return rasterCore;
+	}
+	// early depth testing against the Graphics depth buffer (less, closer is smaller z)
+	void SetDepthTest( bool enable )
+	{
+		Flush();
+		pZBuffer = enable ? &gfx.GetZBuffer() : nullptr;
+	}
+	bool GetDepthTest() const
+	{
+		return pZBuffer != nullptr;
+	}
+	// span occlusion against the Graphics span buffer (opaque constant color effects only)
+	// pixels covered since the frame began are never written again, so what is drawn first ends up
+	// on top: draws have to be submitted front to back, instanced draws walk their instances
+	// back to front (last instance first) so that they look the same as without occlusion
+	// has no effect while depth testing or multisampling is on
+	void SetSpanOcclusion( bool enable )
+	{
+		static_assert(IsConstantShader<PixelShader>::value && !IsAlphaBlended<PixelShader>::value,
+			"span occlusion needs opaque constant color fills");
+		Flush();
+		pSpanBuffer = enable ? &gfx.GetSpanBuffer() : nullptr;
+	}
+	bool GetSpanOcclusion() const
 	{
-		ProcessVertices( triList.vertices,triList.indices );
+		return pSpanBuffer != nullptr;
+	}
+	// 4x multisample antialiasing through the Graphics multisample buffer (opaque constant color effects only)
+	// edges are rasterized at 4 samples per pixel, the color is still written once per covered pixel,
+	// edge pixels are resolved when the frame ends, so anything drawn without multisampling
+	// over multisampled edges in the same frame gets painted over by the resolve
+	// replaces depth testing and span occlusion for this pipeline's draws
+	void SetMultisampling( bool enable )
+	{
+		static_assert(IsConstantShader<PixelShader>::value && !IsAlphaBlended<PixelShader>::value,
+			"multisampling needs opaque constant color fills");
+		Flush();
+		pMultisampleBuffer = enable ? &gfx.GetMultisampleBuffer() : nullptr;
+	}
+	bool GetMultisampling() const
+	{
+		return pMultisampleBuffer != nullptr;
+	}
+	// number of times the persistent scratch storage (vertex shader output, bins)
+	// had to grow, stops changing once frames reach a steady state
+	// only counted in debug builds, always 0 in release
+	size_t GetScratchGrowthCount() const
+	{
+		return scratchGrowthCount;
 	}
 private:
+	template<class Model>
+	static auto ViewOf( const Model& model )
+	{
+		const auto view = MakeTriangleListView( model );
+		static_assert(std::is_same<typename decltype(view)::Vertex,Vertex>::value,"model vertex type doesn't match the effect's");
+		return view;
+	}
+	// binds each instance that isn't culled and calls draw for it
+	// in reverse with span occlusion on, so that the last instance (the topmost) is drawn first
+	template<class Instance,class F>
+	void ForEachInstance( const Instance* pInstances,size_t nInstances,F&& draw )
+	{
+		const auto visit = [&]( const Instance& inst )
+		{
+			if constexpr( HasInstanceCulling<Effect,Instance>::value )
+			{
+				if( !effect.IsInstanceVisible( inst ) )
+				{
+					return;
+				}
+			}
+			effect.BindInstance( inst );
+			draw();
+		};
+		if( pSpanBuffer && !pZBuffer && !pMultisampleBuffer )
+		{
+			for( size_t i = nInstances; i-- > 0; )
+			{
+				visit( pInstances[i] );
+			}
+		}
+		else
+		{
+			for( size_t i = 0; i < nInstances; i++ )
+			{
+				visit( pInstances[i] );
+			}
+		}
+	}
 	// vertex processing function
 	// transforms vertices using vs and then passes vtx & idx lists to triangle assembler
-	void ProcessVertices( const std::vector<Vertex>& vertices,const std::vector<size_t>& indices )
+	template<class Index>
+	void ProcessVertices( ArrayView<Vertex> vertices,ArrayView<Index> indices )
 	{
-		// create vertex vector for vs output
-		std::vector<VSOut> verticesOut( vertices.size() );
-
 		// transform vertices with vs
-		std::transform( vertices.begin(),vertices.end(),
-						verticesOut.begin(),
-						effect.vs );
+		ShadeVertices( vertices );
 
 		// assemble triangles from stream of indices and vertices
-		AssembleTriangles( verticesOut,indices );
+		AssembleTriangles( vsScratch,indices );
+	}
+	// runs the vs over vertices, output goes to scratch storage that only reallocates
+	// when a bigger model comes along
+	// batched vertex shaders get the whole array in one call (see HasBatchVertexShading)
+	void ShadeVertices( ArrayView<Vertex> vertices )
+	{
+		ResizeScratch( vsScratch,vertices.size() );
+		if constexpr( HasBatchVertexShading<typename Effect::VertexShader>::value )
+		{
+			if constexpr( IsAffine2D<Effect>::value )
+			{
+				effect.vs( vertices.data(),vsScratch.data(),vertices.size(),effect.vs.GetTransform() * ndcToScreen );
+			}
+			else
+			{
+				effect.vs( vertices.data(),vsScratch.data(),vertices.size() );
+			}
+		}
+		else
+		{
+			std::transform( vertices.begin(),vertices.end(),
+							vsScratch.begin(),
+							BindVertexShader() );
+		}
+	}
+	// returns the vertex shader to run over the current draw's vertices
+	// for 2D affine effects that is the vs with the model to screen transform composed once up front,
+	// their vertices come out in screen space and skip the screen transform in post processing
+	auto BindVertexShader() const
+	{
+		if constexpr( IsAffine2D<Effect>::value )
+		{
+			static_assert(std::is_same<VSOut,GSOut>::value,"2D affine effects require a pass-through geometry shader");
+			return [&vs = effect.vs,modelToScreen = effect.vs.GetTransform() * ndcToScreen]( const Vertex& in )
+			{
+				return vs( in,modelToScreen );
+			};
+		}
+		else
+		{
+			return std::cref( effect.vs );
+		}
+	}
+	// === scratch storage helpers ===
+	//
+	// scratch vectors are only ever cleared/shrunk logically, their capacity is kept
+	// so that steady state frames don't touch the allocator
+	template<class T>
+	void ResizeScratch( std::vector<T>& v,size_t size )
+	{
+#ifndef NDEBUG
+		if( size > v.capacity() )
+		{
+			scratchGrowthCount++;
+		}
+#endif
+		v.resize( size );
+	}
+	template<class T>
+	void PushScratch( std::vector<T>& v,const T& item )
+	{
+#ifndef NDEBUG
+		if( v.size() == v.capacity() )
+		{
+			scratchGrowthCount++;
+		}
+#endif
+		v.push_back( item );
 	}
 	// triangle assembly function
 	// assembles indexed vertex stream into triangles and passes them to post process
-	// culls (does not send) back facing triangles
-	void AssembleTriangles( const std::vector<VSOut>& vertices,const std::vector<size_t>& indices )
+	// (facing is only known in screen space, culling happens in post process)
+	template<class Index>
+	void AssembleTriangles( const std::vector<VSOut>& vertices,ArrayView<Index> indices )
 	{
 		// assemble triangles in the stream and process
 		for( size_t i = 0,end = indices.size() / 3;
@@ -67,19 +441,353 @@ private:
 	{
 		// generate triangle from 3 vertices using gs
 		// and send to post-processing
-		PostProcessTriangleVertices( effect.gs( v0,v1,v2,triangle_index ) );
+		// (2D affine effects have no gs stage)
+		if constexpr( IsAffine2D<Effect>::value )
+		{
+			PostProcessTriangleVertices( { v0,v1,v2 } );
+		}
+		else
+		{
+			PostProcessTriangleVertices( effect.gs( v0,v1,v2,triangle_index ) );
+		}
 	}
 	// vertex post-processing function
 	// perform perspective and viewport transformations
-	void PostProcessTriangleVertices( Triangle<GSOut>& triangle )
+	// culls (does not send) triangles facing away according to the effect's cull mode,
+	// rejects triangles that are entirely offscreen and clips those that leave the guard band
+	void PostProcessTriangleVertices( Triangle<GSOut> triangle )
 	{
-		// perspective divide and screen transform for all 3 vertices
-		pst.Transform( triangle.v0 );
-		pst.Transform( triangle.v1 );
-		pst.Transform( triangle.v2 );
+		if constexpr( IsPerspective<Effect>::value )
+		{
+			// clip space stage first, survivors come back through ProcessScreenTriangle
+			ClipToNearPlane( triangle );
+		}
+		else
+		{
+			// screen transform for all 3 vertices
+			// (2D affine effects come out of the vs in screen space already)
+			if constexpr( !IsAffine2D<Effect>::value )
+			{
+				pst.Transform( triangle.v0 );
+				pst.Transform( triangle.v1 );
+				pst.Transform( triangle.v2 );
+			}
+			ProcessScreenTriangle( triangle );
+		}
+	}
+	// === clip space functions (perspective effects only) ===
+	//
+	// rejects triangles entirely outside one of the frustum planes and clips the rest
+	// against the near plane (z = 0), which is the only plane where clipping can't be left
+	// to the guard band: vertices behind the eye would flip over in the divide
+	// a triangle with 1 vertex behind becomes a quad (2 triangles), with 2 behind it stays 1 triangle
+	void ClipToNearPlane( const Triangle<GSOut>& triangle )
+	{
+		const auto& p0 = triangle.v0.pos;
+		const auto& p1 = triangle.v1.pos;
+		const auto& p2 = triangle.v2.pos;
+		if( (p0.x > p0.w && p1.x > p1.w && p2.x > p2.w) ||
+			(p0.x < -p0.w && p1.x < -p1.w && p2.x < -p2.w) ||
+			(p0.y > p0.w && p1.y > p1.w && p2.y > p2.w) ||
+			(p0.y < -p0.w && p1.y < -p1.w && p2.y < -p2.w) ||
+			(p0.z > p0.w && p1.z > p1.w && p2.z > p2.w) ||
+			(p0.z < 0.0f && p1.z < 0.0f && p2.z < 0.0f) )
+		{
+			return;
+		}
+
+		const auto clip1 = []( const GSOut& behind,const GSOut& v1,const GSOut& v2,auto submit )
+		{
+			// behind vertex replaced by the 2 points where its edges cross the near plane
+			const GSOut a = interpolate( behind,v1,-behind.pos.z / (v1.pos.z - behind.pos.z) );
+			const GSOut b = interpolate( behind,v2,-behind.pos.z / (v2.pos.z - behind.pos.z) );
+			submit( { a,v1,v2 } );
+			submit( { a,v2,b } );
+		};
+		const auto clip2 = []( const GSOut& inFront,const GSOut& v1,const GSOut& v2,auto submit )
+		{
+			// both behind vertices slide along their edge to the front vertex
+			submit( {
+				inFront,
+				interpolate( v1,inFront,-v1.pos.z / (inFront.pos.z - v1.pos.z) ),
+				interpolate( v2,inFront,-v2.pos.z / (inFront.pos.z - v2.pos.z) ) } );
+		};
+		const auto submit = [this]( Triangle<GSOut> t )
+		{
+			pst.TransformPerspective( t.v0 );
+			pst.TransformPerspective( t.v1 );
+			pst.TransformPerspective( t.v2 );
+			ProcessScreenTriangle( t );
+		};
+
+		const GSOut& v0 = triangle.v0;
+		const GSOut& v1 = triangle.v1;
+		const GSOut& v2 = triangle.v2;
+		// vertex order is rotated (keeping the winding) so that the odd one out comes first
+		const int behind = (p0.z < 0.0f ? 1 : 0) | (p1.z < 0.0f ? 2 : 0) | (p2.z < 0.0f ? 4 : 0);
+		switch( behind )
+		{
+		case 0:
+			submit( triangle );
+			break;
+		case 1:
+			clip1( v0,v1,v2,submit );
+			break;
+		case 2:
+			clip1( v1,v2,v0,submit );
+			break;
+		case 4:
+			clip1( v2,v0,v1,submit );
+			break;
+		case 6:
+			clip2( v0,v1,v2,submit );
+			break;
+		case 5:
+			clip2( v1,v2,v0,submit );
+			break;
+		case 3:
+			clip2( v2,v0,v1,submit );
+			break;
+		}
+	}
+	// screen space stage of post-processing: culling, trivial rejection, guard band
+	void ProcessScreenTriangle( const Triangle<GSOut>& triangle )
+	{
+		if constexpr( EffectCullMode<Effect>::value != CullMode::None )
+		{
+			// screen space winding (y points down, so clockwise is positive)
+			const float area =
+				(triangle.v1.pos.x - triangle.v0.pos.x) * (triangle.v2.pos.y - triangle.v0.pos.y) -
+				(triangle.v1.pos.y - triangle.v0.pos.y) * (triangle.v2.pos.x - triangle.v0.pos.x);
+			if( EffectCullMode<Effect>::value == CullMode::Back ? area <= 0.0f : area >= 0.0f )
+			{
+				return;
+			}
+		}
+
+		// trivial rejection: all 3 vertices outside the same screen edge
+		const Vec3& p0 = triangle.v0.pos;
+		const Vec3& p1 = triangle.v1.pos;
+		const Vec3& p2 = triangle.v2.pos;
+		if( (p0.x < 0.0f && p1.x < 0.0f && p2.x < 0.0f) ||
+			(p0.x > screenWidth && p1.x > screenWidth && p2.x > screenWidth) ||
+			(p0.y < 0.0f && p1.y < 0.0f && p2.y < 0.0f) ||
+			(p0.y > screenHeight && p1.y > screenHeight && p2.y > screenHeight) )
+		{
+			return;
+		}
+
+		// triangles within the guard band are left to the rasterizer's scissoring,
+		// only ones reaching past it need real clipping (keeps setup and row stepping bounded)
+		if( IsInsideGuardBand( p0 ) && IsInsideGuardBand( p1 ) && IsInsideGuardBand( p2 ) )
+		{
+			SubmitTriangle( triangle );
+		}
+		else
+		{
+			ClipToGuardBand( triangle );
+		}
+	}
+	// quad version of the above, same culling/rejection rules applied to all 4 vertices
+	// quads reaching past the guard band are clipped as their 2 triangles instead
+	void PostProcessQuadVertices( Quad quad )
+	{
+		GSOut* v = quad.v;
+		if constexpr( !IsAffine2D<Effect>::value )
+		{
+			for( int i = 0; i < 4; i++ )
+			{
+				pst.Transform( v[i] );
+			}
+		}
+
+		if constexpr( EffectCullMode<Effect>::value != CullMode::None )
+		{
+			// twice the signed area (shoelace over the diagonals), same sign convention as for triangles
+			const float area =
+				(v[2].pos.x - v[0].pos.x) * (v[3].pos.y - v[1].pos.y) -
+				(v[2].pos.y - v[0].pos.y) * (v[3].pos.x - v[1].pos.x);
+			if( EffectCullMode<Effect>::value == CullMode::Back ? area <= 0.0f : area >= 0.0f )
+			{
+				return;
+			}
+		}
+
+		const auto allOutside = [v]( auto outside )
+		{
+			return outside( v[0].pos ) && outside( v[1].pos ) && outside( v[2].pos ) && outside( v[3].pos );
+		};
+		if( allOutside( []( const Vec3& p ) { return p.x < 0.0f; } ) ||
+			allOutside( []( const Vec3& p ) { return p.x > screenWidth; } ) ||
+			allOutside( []( const Vec3& p ) { return p.y < 0.0f; } ) ||
+			allOutside( []( const Vec3& p ) { return p.y > screenHeight; } ) )
+		{
+			return;
+		}
+
+		if( IsInsideGuardBand( v[0].pos ) && IsInsideGuardBand( v[1].pos ) &&
+			IsInsideGuardBand( v[2].pos ) && IsInsideGuardBand( v[3].pos ) )
+		{
+			SubmitQuad( quad );
+		}
+		else
+		{
+			ClipToGuardBand( { v[0],v[1],v[2] } );
+			ClipToGuardBand( { v[0],v[2],v[3] } );
+		}
+	}
+	void SubmitQuad( const Quad& quad )
+	{
+		if( rasterMode == RasterMode::Binned )
+		{
+			BinQuad( quad );
+		}
+		else
+		{
+			DrawQuad( quad,effect.ps,screenClip );
+		}
+	}
+	// sends screen space triangle to the bins or straight to the rasterizer
+	void SubmitTriangle( const Triangle<GSOut>& triangle )
+	{
+		if( rasterMode == RasterMode::Binned )
+		{
+			// defer drawing until flush, tiles rasterize in parallel
+			BinTriangle( triangle );
+		}
+		else
+		{
+			// draw the triangle
+			DrawTriangle( triangle,effect.ps,screenClip );
+		}
+	}
+	// === guard band clipping functions ===
+	//
+	bool IsInsideGuardBand( const Vec3& pos ) const
+	{
+		return pos.x >= -guardBand && pos.x <= screenWidth + guardBand &&
+			pos.y >= -guardBand && pos.y <= screenHeight + guardBand;
+	}
+	// clips triangle against the 4 guard band edges (sutherland-hodgman)
+	// and submits the resulting convex polygon as a triangle fan
+	void ClipToGuardBand( const Triangle<GSOut>& triangle )
+	{
+		// 3 vertices + at most 1 extra per clip edge
+		constexpr int maxVerts = 3 + 4;
+		GSOut polys[2][maxVerts] = { { triangle.v0,triangle.v1,triangle.v2 } };
+		int nVerts = 3;
+		int cur = 0;
+
+		// signed distance inside of each guard band edge (positive is inside)
+		const auto clipEdge = [&]( auto dist )
+		{
+			const GSOut* pIn = polys[cur];
+			GSOut* pOut = polys[cur ^ 1];
+			int nOut = 0;
+			for( int i = 0; i < nVerts; i++ )
+			{
+				const GSOut& a = pIn[i];
+				const GSOut& b = pIn[(i + 1) % nVerts];
+				const float da = dist( a.pos );
+				const float db = dist( b.pos );
+				if( da >= 0.0f )
+				{
+					pOut[nOut++] = a;
+				}
+				if( (da >= 0.0f) != (db >= 0.0f) )
+				{
+					pOut[nOut++] = interpolate( a,b,da / (da - db) );
+				}
+			}
+			nVerts = nOut;
+			cur ^= 1;
+		};
+		clipEdge( []( const Vec3& p ) { return p.x + guardBand; } );
+		clipEdge( []( const Vec3& p ) { return screenWidth + guardBand - p.x; } );
+		clipEdge( []( const Vec3& p ) { return p.y + guardBand; } );
+		clipEdge( []( const Vec3& p ) { return screenHeight + guardBand - p.y; } );
+
+		for( int i = 1; i < nVerts - 1; i++ )
+		{
+			SubmitTriangle( { polys[cur][0],polys[cur][i],polys[cur][i + 1] } );
+		}
+	}
+	// === tile binning functions ===
+	//
+	// stores triangle (with snapshot of the currently bound pixel shader state)
+	// and adds a reference to it to the bin of every tile its bounding box touches
+	void BinTriangle( const Triangle<GSOut>& triangle )
+	{
+		const float xMin = std::min( { triangle.v0.pos.x,triangle.v1.pos.x,triangle.v2.pos.x } );
+		const float xMax = std::max( { triangle.v0.pos.x,triangle.v1.pos.x,triangle.v2.pos.x } );
+		const float yMin = std::min( { triangle.v0.pos.y,triangle.v1.pos.y,triangle.v2.pos.y } );
+		const float yMax = std::max( { triangle.v0.pos.y,triangle.v1.pos.y,triangle.v2.pos.y } );
+
+		if( AddToBins( xMin,xMax,yMin,yMax,(unsigned int)binnedTriangles.size() ) )
+		{
+			PushScratch( binnedTriangles,BinnedTriangle{ triangle,effect.ps } );
+		}
+	}
+	// same for quads, their bin entries are flagged with quadBinFlag
+	void BinQuad( const Quad& quad )
+	{
+		const GSOut* v = quad.v;
+		const float xMin = std::min( { v[0].pos.x,v[1].pos.x,v[2].pos.x,v[3].pos.x } );
+		const float xMax = std::max( { v[0].pos.x,v[1].pos.x,v[2].pos.x,v[3].pos.x } );
+		const float yMin = std::min( { v[0].pos.y,v[1].pos.y,v[2].pos.y,v[3].pos.y } );
+		const float yMax = std::max( { v[0].pos.y,v[1].pos.y,v[2].pos.y,v[3].pos.y } );
+
+		if( AddToBins( xMin,xMax,yMin,yMax,(unsigned int)binnedQuads.size() | quadBinFlag ) )
+		{
+			PushScratch( binnedQuads,BinnedQuad{ quad,effect.ps } );
+		}
+	}
+	// adds bin entry to every tile touched by the bounds, false if that is none
+	bool AddToBins( float xMin,float xMax,float yMin,float yMax,unsigned int entry )
+	{
+		// conservative tile range (pixel centers covered are a subset of [floor(min),ceil(max)])
+		const int tx0 = std::max( int( floor( xMin ) ) / tileSize,0 );
+		const int tx1 = std::min( int( ceil( xMax ) ) / tileSize,nTilesX - 1 );
+		const int ty0 = std::max( int( floor( yMin ) ) / tileSize,0 );
+		const int ty1 = std::min( int( ceil( yMax ) ) / tileSize,nTilesY - 1 );
+		if( tx0 > tx1 || ty0 > ty1 )
+		{
+			return false;
+		}
 
-		// draw the triangle
-		DrawTriangle( triangle );
+		for( int ty = ty0; ty <= ty1; ty++ )
+		{
+			for( int tx = tx0; tx <= tx1; tx++ )
+			{
+				PushScratch( bins[ty * nTilesX + tx],entry );
+			}
+		}
+		return true;
+	}
+	// rasterizes all triangles in a tile's bin in submission order, clipped to the tile
+	// each tile is owned by exactly one thread, so there are no races on the render target
+	void RasterizeTile( int iTile ) const
+	{
+		const int tx = iTile % nTilesX;
+		const int ty = iTile / nTilesX;
+		RectI clip( ty * tileSize,(ty + 1) * tileSize,tx * tileSize,(tx + 1) * tileSize );
+		clip.ClipTo( screenClip );
+
+		for( const auto entry : bins[iTile] )
+		{
+			// (only constant color effects ever bin quads)
+			if constexpr( IsConstantShader<PixelShader>::value )
+			{
+				if( entry & quadBinFlag )
+				{
+					const auto& bq = binnedQuads[entry & ~quadBinFlag];
+					DrawQuad( bq.quad,bq.ps,clip );
+					continue;
+				}
+			}
+			const auto& bt = binnedTriangles[entry];
+			DrawTriangle( bt.triangle,bt.ps,clip );
+		}
 	}
 	// === triangle rasterization functions ===
 	//   it0, it1, etc. stand for interpolants
@@ -87,8 +795,51 @@ private:
 	//
 	// entry point for tri rasterization
 	// sorts vertices, determines case, splits to flat tris, dispatches to flat tri funcs
-	void DrawTriangle( const Triangle<GSOut>& triangle )
+	void DrawTriangle( const Triangle<GSOut>& triangle,const PixelShader& ps,const RectI& clip ) const
 	{
+		if constexpr( IsConstantShader<PixelShader>::value )
+		{
+			if( pMultisampleBuffer )
+			{
+				DrawPolygonMultisample( &triangle.v0,3,ps.GetColor(),clip );
+				return;
+			}
+		}
+		const float zMin = std::min( { triangle.v0.pos.z,triangle.v1.pos.z,triangle.v2.pos.z } );
+		const float zMax = std::max( { triangle.v0.pos.z,triangle.v1.pos.z,triangle.v2.pos.z } );
+		if( pZBuffer && IsBoundsHidden(
+			std::min( { triangle.v0.pos.x,triangle.v1.pos.x,triangle.v2.pos.x } ),
+			std::max( { triangle.v0.pos.x,triangle.v1.pos.x,triangle.v2.pos.x } ),
+			std::min( { triangle.v0.pos.y,triangle.v1.pos.y,triangle.v2.pos.y } ),
+			std::max( { triangle.v0.pos.y,triangle.v1.pos.y,triangle.v2.pos.y } ),
+			zMin,clip ) )
+		{
+			return;
+		}
+		RasterContext rc = { ps,clip,zMin,zMax,{},{} };
+
+		if( rasterCore == RasterCore::HalfSpace )
+		{
+			DrawTriangleHalfSpace( triangle,rc );
+			return;
+		}
+		if( rasterCore == RasterCore::FixedPoint )
+		{
+			DrawTriangleFixedPoint( triangle,rc );
+			return;
+		}
+		if constexpr( !(IsConstantShader<PixelShader>::value && IsAffine2D<Effect>::value) )
+		{
+			if( !MakeAttributePlane( triangle,rc.plane ) )
+			{
+				return;
+			}
+			if constexpr( HasBatchShading<PixelShader>::value )
+			{
+				MakeBatchGradients( rc.plane,rc.gradients );
+			}
+		}
+
 		// using pointers so we can swap (for sorting purposes)
 		const GSOut* pv0 = &triangle.v0;
 		const GSOut* pv1 = &triangle.v1;
@@ -104,14 +855,14 @@ private:
 			// sorting top vertices by x
 			if( pv1->pos.x < pv0->pos.x ) std::swap( pv0,pv1 );
 
-			DrawFlatTopTriangle( *pv0,*pv1,*pv2 );
+			DrawFlatTopTriangle( *pv0,*pv1,*pv2,rc );
 		}
 		else if( pv1->pos.y == pv2->pos.y ) // natural flat bottom
 		{
 			// sorting bottom vertices by x
 			if( pv2->pos.x < pv1->pos.x ) std::swap( pv1,pv2 );
 
-			DrawFlatBottomTriangle( *pv0,*pv1,*pv2 );
+			DrawFlatBottomTriangle( *pv0,*pv1,*pv2,rc );
 		}
 		else // general triangle
 		{
@@ -123,20 +874,21 @@ private:
 
 			if( pv1->pos.x < vi.pos.x ) // major right
 			{
-				DrawFlatBottomTriangle( *pv0,*pv1,vi );
-				DrawFlatTopTriangle( *pv1,vi,*pv2 );
+				DrawFlatBottomTriangle( *pv0,*pv1,vi,rc );
+				DrawFlatTopTriangle( *pv1,vi,*pv2,rc );
 			}
 			else // major left
 			{
-				DrawFlatBottomTriangle( *pv0,vi,*pv1 );
-				DrawFlatTopTriangle( vi,*pv1,*pv2 );
+				DrawFlatBottomTriangle( *pv0,vi,*pv1,rc );
+				DrawFlatTopTriangle( vi,*pv1,*pv2,rc );
 			}
 		}
 	}
 	// does flat *TOP* tri-specific calculations and calls DrawFlatTriangle
 	void DrawFlatTopTriangle( const GSOut& it0,
 							  const GSOut& it1,
-							  const GSOut& it2 )
+							  const GSOut& it2,
+							  const RasterContext& rc ) const
 	{
 		// calulcate dVertex / dy
 		// change in interpolant for every 1 change in y
@@ -148,12 +900,13 @@ private:
 		auto itEdge1 = it1;
 
 		// call the flat triangle render routine
-		DrawFlatTriangle( it0,it1,it2,dit0,dit1,itEdge1 );
+		DrawFlatTriangle( it0,it2,dit0,dit1,itEdge1,rc );
 	}
 	// does flat *BOTTOM* tri-specific calculations and calls DrawFlatTriangle
 	void DrawFlatBottomTriangle( const GSOut& it0,
 								 const GSOut& it1,
-								 const GSOut& it2 )
+								 const GSOut& it2,
+								 const RasterContext& rc ) const
 	{
 		// calulcate dVertex / dy
 		// change in interpolant for every 1 change in y
@@ -165,52 +918,864 @@ private:
 		auto itEdge1 = it0;
 
 		// call the flat triangle render routine
-		DrawFlatTriangle( it0,it1,it2,dit0,dit1,itEdge1 );
+		DrawFlatTriangle( it0,it2,dit0,dit1,itEdge1,rc );
 	}
 	// does processing common to both flat top and flat bottom tris
 	// scan over triangle in screen space, interpolate attributes,
 	// depth cull, invoke ps and write pixel to screen
+	// edge x's and attributes are evaluated directly for each row and pixel (not stepped),
+	// so only the rows and pixels inside the clip rect cost anything and the result
+	// does not depend on where the clip rect starts
 	void DrawFlatTriangle( const GSOut& it0,
-						   const GSOut& it1,
 						   const GSOut& it2,
 						   const GSOut& dv0,
 						   const GSOut& dv1,
-						   GSOut itEdge1 )
+						   const GSOut& itEdge1,
+						   const RasterContext& rc ) const
 	{
-		// create edge interpolant for left edge (always v0)
-		auto itEdge0 = it0;
-
 		// calculate start and end scanlines
-		const int yStart = (int)ceil( it0.pos.y - 0.5f );
-		const int yEnd = (int)ceil( it2.pos.y - 0.5f ); // the scanline AFTER the last line drawn
+		const int yStart = std::max( (int)ceil( it0.pos.y - 0.5f ),rc.clip.top );
+		const int yEnd = std::min( (int)ceil( it2.pos.y - 0.5f ),rc.clip.bottom ); // the scanline AFTER the last line drawn
+		const AttributePlane& plane = rc.plane;
 
-		// do interpolant prestep
-		itEdge0 += dv0 * (float( yStart ) + 0.5f - it0.pos.y);
-		itEdge1 += dv1 * (float( yStart ) + 0.5f - it0.pos.y);
-
-		for( int y = yStart; y < yEnd; y++,itEdge0 += dv0,itEdge1 += dv1 )
+		for( int y = yStart; y < yEnd; y++ )
 		{
 			// calculate start and end pixels
-			const int xStart = (int)ceil( itEdge0.pos.x - 0.5f );
-			const int xEnd = (int)ceil( itEdge1.pos.x - 0.5f ); // the pixel AFTER the last pixel drawn
+			const float dy = float( y ) + 0.5f - it0.pos.y;
+			const int xStart = std::max( (int)ceil( it0.pos.x + dv0.pos.x * dy - 0.5f ),rc.clip.left );
+			const int xEnd = std::min( (int)ceil( itEdge1.pos.x + dv1.pos.x * dy - 0.5f ),rc.clip.right ); // the pixel AFTER the last pixel drawn
+			if( xStart >= xEnd )
+			{
+				continue;
+			}
 
-			// create scanline interpolant startpoint
-			// (some waste for interpolating x,y,z, but makes life easier not having
-			//  to split them off, and z will be needed in the future anyways...)
-			auto iLine = itEdge0;
+			if constexpr( IsConstantShader<PixelShader>::value )
+			{
+				// nothing to interpolate, fill whole spans
+				const Color c = rc.ps.GetColor();
+				if( !pZBuffer )
+				{
+					FillSpan( xStart,xEnd,y,c );
+				}
+				else if constexpr( IsAffine2D<Effect>::value )
+				{
+					// depth is constant over the whole draw
+					FillSpanDepth( xStart,xEnd,y,rc.zMin,0.0f,c,rc );
+				}
+				else
+				{
+					FillSpanDepth( xStart,xEnd,y,plane.origin.pos.z + plane.dvdy.pos.z * float( y ),plane.dvdx.pos.z,c,rc );
+				}
+			}
+			else if constexpr( HasBatchShading<PixelShader>::value )
+			{
+				DrawSpanBatched( xStart,xEnd,y,rc );
+			}
+			else
+			{
+				if( pZBuffer && pZBuffer->IsSpanOccluded( xStart,xEnd,y,rc.zMin ) )
+				{
+					continue;
+				}
+				// interpolants at the start of the row (x = 0)
+				const GSOut iRow = plane.origin + plane.dvdy * float( y );
+				for( int x = xStart; x < xEnd; x++ )
+				{
+					const GSOut iPixel = iRow + plane.dvdx * float( x );
+					// early depth test before invoking the pixel shader
+					if( !pZBuffer || pZBuffer->TestAndSet( x,y,iPixel.pos.z ) )
+					{
+						// invoke pixel shader with interpolated vertex attributes
+						// and use result to set the pixel color on the screen
+						gfx.PutPixel( x,y,rc.ps( PerspectiveCorrect( iPixel ) ) );
+					}
+				}
+			}
+		}
+	}
+	// interpolated attributes as the pixel shader expects them
+	// perspective effects interpolate attribute / w (see IsPerspective), so they get multiplied
+	// by w again, which is 1 over the interpolated pos.w
+	static decltype(auto) PerspectiveCorrect( const GSOut& v )
+	{
+		if constexpr( IsPerspective<Effect>::value )
+		{
+			return v * (1.0f / v.pos.w);
+		}
+		else
+		{
+			return v;
+		}
+	}
+	// screen space plane of the interpolants over the triangle, false if the triangle has no area
+	static bool MakeAttributePlane( const Triangle<GSOut>& triangle,AttributePlane& plane )
+	{
+		const GSOut& v0 = triangle.v0;
+		const float d1x = triangle.v1.pos.x - v0.pos.x;
+		const float d1y = triangle.v1.pos.y - v0.pos.y;
+		const float d2x = triangle.v2.pos.x - v0.pos.x;
+		const float d2y = triangle.v2.pos.y - v0.pos.y;
+		const float denom = d1x * d2y - d2x * d1y;
+		if( denom == 0.0f )
+		{
+			return false;
+		}
+		const GSOut d1 = triangle.v1 - v0;
+		const GSOut d2 = triangle.v2 - v0;
+		plane.dvdx = (d1 * d2y - d2 * d1y) / denom;
+		plane.dvdy = (d2 * d1x - d1 * d2x) / denom;
+		// extrapolated from v0 to the center of pixel (0,0)
+		plane.origin = v0 + plane.dvdx * (0.5f - v0.pos.x) + plane.dvdy * (0.5f - v0.pos.y);
+		return true;
+	}
+	// the attribute plane in the form the batch shader takes it
+	static void MakeBatchGradients( const AttributePlane& plane,BatchGradients& gradients )
+	{
+		constexpr int nAttributes = BatchAttributeCount<PixelShader>::value;
+		PixelShader::LoadAttributes( plane.origin,gradients.origin );
+		PixelShader::LoadAttributes( plane.dvdx,gradients.dadx );
+		PixelShader::LoadAttributes( plane.dvdy,gradients.dady );
+		for( int i = 0; i < nAttributes; i++ )
+		{
+			gradients.ramp[i] = FloatBlock::Ramp( 0.0f,gradients.dadx[i] );
+		}
+	}
+	// shades span [xStart,xEnd) on scanline y FloatBlock::width pixels at a time
+	// attributes are held structure of arrays (one block per attribute) and evaluated
+	// from the attribute plane at the start of each block
+	// blocks are aligned to absolute screen x like in the half-space core
+	void DrawSpanBatched( int xStart,int xEnd,int y,const RasterContext& rc ) const
+	{
+		const AttributePlane& plane = rc.plane;
+		const BatchGradients& gradients = rc.gradients;
+		constexpr int blockWidth = FloatBlock::width;
+		constexpr int nAttributes = BatchAttributeCount<PixelShader>::value;
+		if( pZBuffer && pZBuffer->IsSpanOccluded( xStart,xEnd,y,rc.zMin ) )
+		{
+			return;
+		}
 
-			// calculate delta scanline interpolant / dx
-			const float dx = itEdge1.pos.x - itEdge0.pos.x;
-			const auto diLine = (itEdge1 - iLine) / dx;
+		// attributes and depth at the start of the row (x = 0)
+		float aRow[nAttributes];
+		for( int i = 0; i < nAttributes; i++ )
+		{
+			aRow[i] = gradients.origin[i] + gradients.dady[i] * float( y );
+		}
+		const float zRow = plane.origin.pos.z + plane.dvdy.pos.z * float( y );
+		const float dzdx = plane.dvdx.pos.z;
 
-			// prestep scanline interpolant
-			iLine += diLine * (float( xStart ) + 0.5f - itEdge0.pos.x);
+		FloatBlock attributes[nAttributes];
+		Color colors[blockWidth];
+		for( int xb = xStart - (xStart % blockWidth); xb < xEnd; xb += blockWidth )
+		{
+			// lanes inside the span
+			const int lo = std::max( xStart - xb,0 );
+			const int hi = std::min( xEnd - xb,blockWidth );
+			int mask = ((1 << hi) - 1) & ~((1 << lo) - 1);
+			if( pZBuffer )
+			{
+				// early depth test, drop hidden lanes before shading
+				for( int lane = lo; lane < hi; lane++ )
+				{
+					if( !pZBuffer->TestAndSet( xb + lane,y,zRow + dzdx * float( xb + lane ) ) )
+					{
+						mask &= ~(1 << lane);
+					}
+				}
+			}
+			if( mask != 0 )
+			{
+				for( int i = 0; i < nAttributes; i++ )
+				{
+					attributes[i] = FloatBlock::Broadcast( aRow[i] + gradients.dadx[i] * float( xb ) ) + gradients.ramp[i];
+				}
+				rc.ps( attributes,colors );
+				gfx.PutPixelsMasked( xb,y,colors,(unsigned int)mask,hi );
+			}
+		}
+	}
+	// constant color span fill, only the gaps still open in the span buffer get written with span occlusion
+	void FillSpan( int xStart,int xEnd,int y,Color c ) const
+	{
+		if( pSpanBuffer )
+		{
+			pSpanBuffer->Cover( xStart,xEnd,y,[this,y,c]( int gapStart,int gapEnd )
+			{
+				WriteSpan( gapStart,gapEnd,y,c );
+			} );
+		}
+		else
+		{
+			WriteSpan( xStart,xEnd,y,c );
+		}
+	}
+	// constant color writes to the render target, composited over it for alpha blended shaders
+	void WriteSpan( int xStart,int xEnd,int y,Color c ) const
+	{
+		if constexpr( IsAlphaBlended<PixelShader>::value )
+		{
+			gfx.BlendSpan( xStart,xEnd,y,c );
+		}
+		else
+		{
+			gfx.FillSpan( xStart,xEnd,y,c );
+		}
+	}
+	void WritePixel( int x,int y,Color c ) const
+	{
+		if constexpr( IsAlphaBlended<PixelShader>::value )
+		{
+			gfx.PutPixelAlpha( x,y,c );
+		}
+		else
+		{
+			gfx.PutPixel( x,y,c );
+		}
+	}
+	// fills a constant color span with depth testing, z = zRow + dzdx * x (zRow is the depth at x = 0)
+	// z is evaluated at each pixel rather than stepped from xStart, so it does not depend on
+	// where the span was clipped (binned tiles get the same depths as an immediate draw)
+	// the coarse tiles let fully hidden spans be skipped and fully visible spans skip the per-pixel test
+	void FillSpanDepth( int xStart,int xEnd,int y,float zRow,float dzdx,Color c,const RasterContext& rc ) const
+	{
+		if( pZBuffer->IsSpanOccluded( xStart,xEnd,y,rc.zMin ) )
+		{
+			return;
+		}
+		if( pZBuffer->IsSpanUnoccluded( xStart,xEnd,y,rc.zMax ) )
+		{
+			for( int x = xStart; x < xEnd; x++ )
+			{
+				pZBuffer->Set( x,y,zRow + dzdx * float( x ) );
+			}
+			WriteSpan( xStart,xEnd,y,c );
+			return;
+		}
+		for( int x = xStart; x < xEnd; x++ )
+		{
+			if( pZBuffer->TestAndSet( x,y,zRow + dzdx * float( x ) ) )
+			{
+				WritePixel( x,y,c );
+			}
+		}
+	}
+	// coarse depth test of a whole primitive against the tiles under its screen space bounds
+	// true if nothing can pass there (or the bounds don't cover any pixel inside clip)
+	bool IsBoundsHidden( float xMin,float xMax,float yMin,float yMax,float zMin,const RectI& clip ) const
+	{
+		RectI bounds(
+			(int)ceil( yMin - 0.5f ),
+			(int)ceil( yMax - 0.5f ),
+			(int)ceil( xMin - 0.5f ),
+			(int)ceil( xMax - 0.5f ) );
+		bounds.ClipTo( clip );
+		return bounds.left >= bounds.right || bounds.top >= bounds.bottom ||
+			pZBuffer->IsOccluded( bounds,zMin );
+	}
+	// === quad rasterization ===
+	//
+	// fills convex quad (constant color shaders only) scanline by scanline
+	// every edge is a half-plane bound on x: edges going up the screen bound the span on the left,
+	// edges going down bound it on the right (clockwise winding), so a row's span is simply
+	// max of the left edge x's to min of the right edge x's, no sorting/splitting needed
+	// same pixel center and top-left conventions as the scanline triangle core
+	void DrawQuad( const Quad& quad,const PixelShader& ps,const RectI& clip ) const
+	{
+		if( pMultisampleBuffer )
+		{
+			DrawPolygonMultisample( quad.v,4,ps.GetColor(),clip );
+			return;
+		}
+		const GSOut* v = quad.v;
+		const float zMin = std::min( { v[0].pos.z,v[1].pos.z,v[2].pos.z,v[3].pos.z } );
+		const float zMax = std::max( { v[0].pos.z,v[1].pos.z,v[2].pos.z,v[3].pos.z } );
+		const float yMin = std::min( { v[0].pos.y,v[1].pos.y,v[2].pos.y,v[3].pos.y } );
+		const float yMax = std::max( { v[0].pos.y,v[1].pos.y,v[2].pos.y,v[3].pos.y } );
+		if( pZBuffer && IsBoundsHidden(
+			std::min( { v[0].pos.x,v[1].pos.x,v[2].pos.x,v[3].pos.x } ),
+			std::max( { v[0].pos.x,v[1].pos.x,v[2].pos.x,v[3].pos.x } ),
+			yMin,yMax,zMin,clip ) )
+		{
+			return;
+		}
+		const RasterContext rc = { ps,clip,zMin,zMax,{},{} };
+
+		// winding from twice the signed area, flip edge directions for counter-clockwise quads
+		const float area =
+			(v[2].pos.x - v[0].pos.x) * (v[3].pos.y - v[1].pos.y) -
+			(v[2].pos.y - v[0].pos.y) * (v[3].pos.x - v[1].pos.x);
+		if( area == 0.0f )
+		{
+			return;
+		}
+		const float dir = area > 0.0f ? 1.0f : -1.0f;
 
-			for( int x = xStart; x < xEnd; x++,iLine += diLine )
+		// edge x at scanline center yc is x0 + dxdy * (yc - y0)
+		float x0Left[4],y0Left[4],dxdyLeft[4];
+		float x0Right[4],y0Right[4],dxdyRight[4];
+		int nLeft = 0;
+		int nRight = 0;
+		for( int i = 0; i < 4; i++ )
+		{
+			const Vec3& a = v[i].pos;
+			const Vec3& b = v[(i + 1) % 4].pos;
+			const float dy = (b.y - a.y) * dir;
+			// horizontal edges don't bound x, the row range takes care of them
+			if( dy < 0.0f )
+			{
+				x0Left[nLeft] = a.x;
+				y0Left[nLeft] = a.y;
+				dxdyLeft[nLeft++] = (b.x - a.x) / (b.y - a.y);
+			}
+			else if( dy > 0.0f )
+			{
+				x0Right[nRight] = a.x;
+				y0Right[nRight] = a.y;
+				dxdyRight[nRight++] = (b.x - a.x) / (b.y - a.y);
+			}
+		}
+
+		// depth plane through the first 3 vertices (flat for 2D affine effects)
+		float dzdx = 0.0f;
+		float dzdy = 0.0f;
+		if constexpr( !IsAffine2D<Effect>::value )
+		{
+			const Vec3 d1 = v[1].pos - v[0].pos;
+			const Vec3 d2 = v[2].pos - v[0].pos;
+			const float nz = d1.x * d2.y - d1.y * d2.x;
+			if( nz != 0.0f )
+			{
+				dzdx = (d1.y * d2.z - d1.z * d2.y) / -nz;
+				dzdy = (d1.z * d2.x - d1.x * d2.z) / -nz;
+			}
+		}
+
+		const Color c = rc.ps.GetColor();
+		const int yStart = std::max( (int)ceil( yMin - 0.5f ),clip.top );
+		const int yEnd = std::min( (int)ceil( yMax - 0.5f ),clip.bottom );
+		for( int y = yStart; y < yEnd; y++ )
+		{
+			// edge x's are evaluated directly for each row (not stepped)
+			// so the result does not depend on where the clip rect starts
+			const float yc = float( y ) + 0.5f;
+			float xLeft = float( clip.left );
+			float xRight = float( clip.right );
+			for( int i = 0; i < nLeft; i++ )
+			{
+				xLeft = std::max( xLeft,x0Left[i] + dxdyLeft[i] * (yc - y0Left[i]) - 0.5f );
+			}
+			for( int i = 0; i < nRight; i++ )
+			{
+				xRight = std::min( xRight,x0Right[i] + dxdyRight[i] * (yc - y0Right[i]) - 0.5f );
+			}
+			if( xLeft >= xRight )
+			{
+				continue;
+			}
+			const int xStart = (int)ceil( xLeft );
+			const int xEnd = (int)ceil( xRight );
+			if( xStart >= xEnd )
+			{
+				continue;
+			}
+			if( pZBuffer )
+			{
+				const float zRow = v[0].pos.z + dzdx * (0.5f - v[0].pos.x) + dzdy * (yc - v[0].pos.y);
+				FillSpanDepth( xStart,xEnd,y,zRow,dzdx,c,rc );
+			}
+			else
+			{
+				FillSpan( xStart,xEnd,y,c );
+			}
+		}
+	}
+	// === multisample rasterization ===
+	//
+	// convex polygon (triangle or quad, constant color shaders only) covered at the 4 sample
+	// positions of MultisampleBuffer, with the same edge setup as DrawQuad
+	// every row gets the span covered by each of the samples: pixels inside all 4 spans are filled
+	// as usual, only the few at the ends that are inside some of them go to the multisample buffer
+	void DrawPolygonMultisample( const GSOut* v,int nVerts,Color c,const RectI& clip ) const
+	{
+		constexpr int nSamples = MultisampleBuffer::nSamples;
+		constexpr int maxVerts = 4;
+		assert( nVerts <= maxVerts );
+
+		// winding from twice the signed area (shoelace), flip edge directions for counter-clockwise polygons
+		float area = 0.0f;
+		float yMin = v[0].pos.y;
+		float yMax = v[0].pos.y;
+		for( int i = 0; i < nVerts; i++ )
+		{
+			const Vec3& a = v[i].pos;
+			const Vec3& b = v[(i + 1) % nVerts].pos;
+			area += a.x * b.y - b.x * a.y;
+			yMin = std::min( yMin,a.y );
+			yMax = std::max( yMax,a.y );
+		}
+		if( area == 0.0f )
+		{
+			return;
+		}
+		const float dir = area > 0.0f ? 1.0f : -1.0f;
+
+		// the samples are the first nSamples lanes of a block (other lanes of wider blocks stay uncovered),
+		// spans of all samples are worked out together
+		static_assert(nSamples <= FloatBlock::width,"samples have to fit in a block");
+		constexpr int sampleLanes = (1 << nSamples) - 1;
+		const FloatBlock sampleX = FloatBlock::LoadStrided( MultisampleBuffer::sampleX,sizeof( float ),nSamples );
+		const FloatBlock sampleY = FloatBlock::LoadStrided( MultisampleBuffer::sampleY,sizeof( float ),nSamples );
+		// edge x at sample row ys is x0 + dxdy * (ys - y0), x0 with the sample's x offset taken out
+		FloatBlock x0Left[maxVerts],y0Left[maxVerts],dxdyLeft[maxVerts];
+		FloatBlock x0Right[maxVerts],y0Right[maxVerts],dxdyRight[maxVerts];
+		int nLeft = 0;
+		int nRight = 0;
+		for( int i = 0; i < nVerts; i++ )
+		{
+			const Vec3& a = v[i].pos;
+			const Vec3& b = v[(i + 1) % nVerts].pos;
+			const float dy = (b.y - a.y) * dir;
+			if( dy != 0.0f )
+			{
+				const float dxdy = (b.x - a.x) / (b.y - a.y);
+				const FloatBlock x0 = FloatBlock::Broadcast( a.x ) - sampleX;
+				if( dy < 0.0f )
+				{
+					x0Left[nLeft] = x0;
+					y0Left[nLeft] = FloatBlock::Broadcast( a.y );
+					dxdyLeft[nLeft++] = FloatBlock::Broadcast( dxdy );
+				}
+				else
+				{
+					x0Right[nRight] = x0;
+					y0Right[nRight] = FloatBlock::Broadcast( a.y );
+					dxdyRight[nRight++] = FloatBlock::Broadcast( dxdy );
+				}
+			}
+		}
+		const FloatBlock yMinBlock = FloatBlock::Broadcast( yMin );
+		const FloatBlock yMaxBlock = FloatBlock::Broadcast( yMax );
+		const FloatBlock clipLeft = FloatBlock::Broadcast( float( clip.left ) );
+		const FloatBlock clipRight = FloatBlock::Broadcast( float( clip.right ) );
+
+		// rows with any sample inside [yMin,yMax)
+		const int yStart = std::max( (int)ceil( yMin - MultisampleBuffer::sampleY[nSamples - 1] ),clip.top );
+		const int yEnd = std::min( (int)ceil( yMax - MultisampleBuffer::sampleY[0] ),clip.bottom );
+		for( int y = yStart; y < yEnd; y++ )
+		{
+			const FloatBlock ys = FloatBlock::Broadcast( float( y ) ) + sampleY;
+			int covered = sampleLanes & ys.MaskGreaterEqual( yMinBlock ) & yMaxBlock.MaskGreater( ys );
+			if( covered == 0 )
+			{
+				continue;
+			}
+			// pixel x has sample s covered for spanStart[s] <= x < spanEnd[s]
+			FloatBlock xLeft = clipLeft;
+			FloatBlock xRight = clipRight;
+			for( int i = 0; i < nLeft; i++ )
+			{
+				xLeft = xLeft.Max( x0Left[i] + dxdyLeft[i] * (ys - y0Left[i]) );
+			}
+			for( int i = 0; i < nRight; i++ )
+			{
+				xRight = xRight.Min( x0Right[i] + dxdyRight[i] * (ys - y0Right[i]) );
+			}
+			const FloatBlock spanStart = xLeft.Ceil();
+			const FloatBlock spanEnd = xRight.Ceil();
+			covered &= spanEnd.MaskGreater( spanStart );
+			if( covered == 0 )
+			{
+				continue;
+			}
+
+			// union of the sample spans, and their intersection (the fully covered pixels)
+			float starts[FloatBlock::width];
+			float ends[FloatBlock::width];
+			spanStart.Store( starts );
+			spanEnd.Store( ends );
+			int outerStart = clip.right;
+			int outerEnd = clip.left;
+			int innerStart = clip.left;
+			int innerEnd = clip.right;
+			for( int s = 0; s < nSamples; s++ )
+			{
+				if( covered & (1 << s) )
+				{
+					outerStart = std::min( outerStart,int( starts[s] ) );
+					outerEnd = std::max( outerEnd,int( ends[s] ) );
+					innerStart = std::max( innerStart,int( starts[s] ) );
+					innerEnd = std::min( innerEnd,int( ends[s] ) );
+				}
+			}
+			if( covered == sampleLanes && innerStart < innerEnd )
+			{
+				gfx.FillSpan( innerStart,innerEnd,y,c );
+				pMultisampleBuffer->Cover( innerStart,innerEnd,y );
+			}
+			else
+			{
+				// no pixel fully covered, the whole union is edge
+				innerStart = innerEnd = outerEnd;
+			}
+			const auto writeEdge = [&]( int xStart,int xEnd )
+			{
+				for( int x = xStart; x < xEnd; x++ )
+				{
+					const FloatBlock xBlock = FloatBlock::Broadcast( float( x ) );
+					const int mask = covered & xBlock.MaskGreaterEqual( spanStart ) & spanEnd.MaskGreater( xBlock );
+					if( mask != 0 )
+					{
+						pMultisampleBuffer->Write( x,y,(unsigned int)mask,c,gfx.GetPixel( x,y ) );
+					}
+				}
+			};
+			writeEdge( outerStart,innerStart );
+			writeEdge( innerEnd,outerEnd );
+		}
+	}
+	// === half-space rasterization ===
+	//
+	// scans the (clipped) bounding box in blocks of FloatBlock::width pixels,
+	// testing pixel centers against the 3 edge functions of the triangle in parallel
+	// and writing the covered pixels of each block with one masked store
+	void DrawTriangleHalfSpace( const Triangle<GSOut>& triangle,const RasterContext& rc ) const
+	{
+		constexpr int blockWidth = FloatBlock::width;
+
+		const GSOut* pv0 = &triangle.v0;
+		const GSOut* pv1 = &triangle.v1;
+		const GSOut* pv2 = &triangle.v2;
+
+		// twice the signed area, make it positive by fixing up the winding
+		float area = (pv1->pos.x - pv0->pos.x) * (pv2->pos.y - pv0->pos.y) -
+			(pv1->pos.y - pv0->pos.y) * (pv2->pos.x - pv0->pos.x);
+		if( area == 0.0f )
+		{
+			return;
+		}
+		if( area < 0.0f )
+		{
+			std::swap( pv1,pv2 );
+			area = -area;
+		}
+
+		// bounding box in pixels, same pixel center convention as the scanline core
+		const int xStart = std::max( (int)ceil( std::min( { pv0->pos.x,pv1->pos.x,pv2->pos.x } ) - 0.5f ),rc.clip.left );
+		const int xEnd = std::min( (int)ceil( std::max( { pv0->pos.x,pv1->pos.x,pv2->pos.x } ) - 0.5f ),rc.clip.right );
+		const int yStart = std::max( (int)ceil( std::min( { pv0->pos.y,pv1->pos.y,pv2->pos.y } ) - 0.5f ),rc.clip.top );
+		const int yEnd = std::min( (int)ceil( std::max( { pv0->pos.y,pv1->pos.y,pv2->pos.y } ) - 0.5f ),rc.clip.bottom );
+		if( xStart >= xEnd || yStart >= yEnd )
+		{
+			return;
+		}
+		// blocks are aligned to absolute screen x so that they never straddle a tile boundary
+		const int xBlockStart = xStart - (xStart % blockWidth);
+
+		// edge i is opposite vertex i, value at pixel center p is (b - a) x (p - a)
+		// which is positive on the inside for every edge now that the winding is fixed
+		// edge values are evaluated directly for each row and block (not stepped from the bbox corner)
+		// so that they do not depend on where the clip rect starts
+		const Vec2 a[3] = { pv1->pos,pv2->pos,pv0->pos };
+		const Vec2 b[3] = { pv2->pos,pv0->pos,pv1->pos };
+		float dx[3];
+		float dy[3];
+		bool topLeft[3];
+		for( int i = 0; i < 3; i++ )
+		{
+			dx[i] = b[i].x - a[i].x;
+			dy[i] = b[i].y - a[i].y;
+			// pixel centers exactly on a top or left edge are drawn, those on bottom/right edges are not
+			topLeft[i] = dy[i] < 0.0f || (dy[i] == 0.0f && dx[i] > 0.0f);
+		}
+		const FloatBlock zero = FloatBlock::Broadcast( 0.0f );
+
+		// attribute deltas for barycentric interpolation
+		const auto d10 = *pv1 - *pv0;
+		const auto d20 = *pv2 - *pv0;
+		const float areaInv = 1.0f / area;
+
+		alignas(32) float w1[blockWidth];
+		alignas(32) float w2[blockWidth];
+		Color colors[blockWidth];
+		// batch shaders get their attributes straight from the edge blocks: a0 + da1 * e1 + da2 * e2
+		constexpr int nBatchAttributes = BatchAttributeCount<PixelShader>::value;
+		FloatBlock a0[nBatchAttributes];
+		FloatBlock da1[nBatchAttributes];
+		FloatBlock da2[nBatchAttributes];
+		if constexpr( HasBatchShading<PixelShader>::value )
+		{
+			float a[nBatchAttributes];
+			PixelShader::LoadAttributes( *pv0,a );
+			float a1[nBatchAttributes];
+			PixelShader::LoadAttributes( d10,a1 );
+			float a2[nBatchAttributes];
+			PixelShader::LoadAttributes( d20,a2 );
+			for( int i = 0; i < nBatchAttributes; i++ )
+			{
+				a0[i] = FloatBlock::Broadcast( a[i] );
+				da1[i] = FloatBlock::Broadcast( a1[i] * areaInv );
+				da2[i] = FloatBlock::Broadcast( a2[i] * areaInv );
+			}
+		}
+		if constexpr( IsConstantShader<PixelShader>::value )
+		{
+			// every lane gets the same color, shade once up front
+			std::fill( std::begin( colors ),std::end( colors ),rc.ps.GetColor() );
+		}
+
+		for( int y = yStart; y < yEnd; y++ )
+		{
+			float eRow[3];
+			for( int i = 0; i < 3; i++ )
+			{
+				eRow[i] = dx[i] * (float( y ) + 0.5f - a[i].y);
+			}
+			// covered run of the row, gathered over the blocks for span occlusion
+			int runStart = xEnd;
+			int runEnd = xEnd;
+
+			for( int xb = xBlockStart; xb < xEnd; xb += blockWidth )
+			{
+				FloatBlock e[3];
+				for( int i = 0; i < 3; i++ )
+				{
+					e[i] = FloatBlock::Ramp( eRow[i] - dy[i] * (float( xb ) + 0.5f - a[i].x),-dy[i] );
+				}
+				// lanes inside the bbox span
+				const int lo = std::max( xStart - xb,0 );
+				const int hi = std::min( xEnd - xb,blockWidth );
+				int mask = ((1 << hi) - 1) & ~((1 << lo) - 1);
+				for( int i = 0; i < 3 && mask != 0; i++ )
+				{
+					mask &= topLeft[i] ? e[i].MaskGreaterEqual( zero ) : e[i].MaskGreater( zero );
+				}
+				if( mask == 0 )
+				{
+					continue;
+				}
+
+				// weights of v1 and v2 are the edge values opposite them
+				if( pZBuffer || !(IsConstantShader<PixelShader>::value || HasBatchShading<PixelShader>::value) )
+				{
+					e[1].Store( w1 );
+					e[2].Store( w2 );
+				}
+				if( pZBuffer )
+				{
+					// early depth test, drop lanes that are hidden before shading
+					for( int lane = 0; lane < blockWidth; lane++ )
+					{
+						if( (mask & (1 << lane)) &&
+							!pZBuffer->TestAndSet( xb + lane,y,pv0->pos.z + d10.pos.z * (w1[lane] * areaInv) + d20.pos.z * (w2[lane] * areaInv) ) )
+						{
+							mask &= ~(1 << lane);
+						}
+					}
+					if( mask == 0 )
+					{
+						continue;
+					}
+				}
+				if constexpr( HasBatchShading<PixelShader>::value )
+				{
+					// shade the whole block, uncovered lanes are masked off on store
+					FloatBlock attributes[nBatchAttributes];
+					for( int i = 0; i < nBatchAttributes; i++ )
+					{
+						attributes[i] = a0[i] + da1[i] * e[1] + da2[i] * e[2];
+					}
+					rc.ps( attributes,colors );
+				}
+				else if constexpr( !IsConstantShader<PixelShader>::value )
+				{
+					// shade covered lanes
+					for( int lane = 0; lane < blockWidth; lane++ )
+					{
+						if( mask & (1 << lane) )
+						{
+							colors[lane] = rc.ps( PerspectiveCorrect( *pv0 + d10 * (w1[lane] * areaInv) + d20 * (w2[lane] * areaInv) ) );
+						}
+					}
+				}
+				if constexpr( IsConstantShader<PixelShader>::value )
+				{
+					if( (pSpanBuffer || IsAlphaBlended<PixelShader>::value) && !pZBuffer )
+					{
+						// the covered lanes continue the run (a row of a convex triangle is one span)
+						int laneStart = 0;
+						int laneEnd = blockWidth;
+						while( !(mask & (1 << laneStart)) )
+						{
+							laneStart++;
+						}
+						while( !(mask & (1 << (laneEnd - 1))) )
+						{
+							laneEnd--;
+						}
+						runStart = std::min( runStart,xb + laneStart );
+						runEnd = xb + laneEnd;
+						continue;
+					}
+					if constexpr( IsAlphaBlended<PixelShader>::value )
+					{
+						// depth tested lanes, not necessarily contiguous
+						for( int lane = 0; lane < blockWidth; lane++ )
+						{
+							if( mask & (1 << lane) )
+							{
+								WritePixel( xb + lane,y,rc.ps.GetColor() );
+							}
+						}
+						continue;
+					}
+				}
+				gfx.PutPixelsMasked( xb,y,colors,(unsigned int)mask,hi );
+			}
+			if constexpr( IsConstantShader<PixelShader>::value )
+			{
+				if( runStart < runEnd )
+				{
+					FillSpan( runStart,runEnd,y,rc.ps.GetColor() );
+				}
+			}
+		}
+	}
+	// === fixed point rasterization ===
+	//
+	// vertices are snapped to 24.8 fixed point and the edge functions are evaluated in 64-bit integers,
+	// so edges shared between triangles give exactly opposite values and every pixel center on them
+	// is owned by exactly one side (top-left rule via a -1 bias on the other edges)
+	// each row's span is solved directly from the 3 edge values, which are stepped incrementally
+	void DrawTriangleFixedPoint( const Triangle<GSOut>& triangle,const RasterContext& rc ) const
+	{
+		constexpr int subBits = 8;
+		constexpr int subOne = 1 << subBits;
+		constexpr int subHalf = subOne / 2;
+		const auto toFixed = []( float v )
+		{
+			return int( floor( v * float( subOne ) + 0.5f ) );
+		};
+
+		const GSOut* pv0 = &triangle.v0;
+		const GSOut* pv1 = &triangle.v1;
+		const GSOut* pv2 = &triangle.v2;
+		int x[3] = { toFixed( pv0->pos.x ),toFixed( pv1->pos.x ),toFixed( pv2->pos.x ) };
+		int y[3] = { toFixed( pv0->pos.y ),toFixed( pv1->pos.y ),toFixed( pv2->pos.y ) };
+
+		// twice the signed area in 16.16, fix up winding so that it is positive
+		long long area = (long long)(x[1] - x[0]) * (y[2] - y[0]) - (long long)(y[1] - y[0]) * (x[2] - x[0]);
+		if( area == 0 )
+		{
+			return;
+		}
+		if( area < 0 )
+		{
+			std::swap( pv1,pv2 );
+			std::swap( x[1],x[2] );
+			std::swap( y[1],y[2] );
+			area = -area;
+		}
+
+		// pixel px is a candidate if its center px * 256 + 128 lies within the vertex extents
+		const int xMinFixed = std::min( { x[0],x[1],x[2] } );
+		const int xMaxFixed = std::max( { x[0],x[1],x[2] } );
+		const int yMinFixed = std::min( { y[0],y[1],y[2] } );
+		const int yMaxFixed = std::max( { y[0],y[1],y[2] } );
+		const int xStart = std::max( (xMinFixed - subHalf + subOne - 1) >> subBits,rc.clip.left );
+		const int xEnd = std::min( ((xMaxFixed - subHalf) >> subBits) + 1,rc.clip.right );
+		const int yStart = std::max( (yMinFixed - subHalf + subOne - 1) >> subBits,rc.clip.top );
+		const int yEnd = std::min( ((yMaxFixed - subHalf) >> subBits) + 1,rc.clip.bottom );
+		if( xStart >= xEnd || yStart >= yEnd )
+		{
+			return;
+		}
+
+		// edge i is opposite vertex i, evaluated at the center of pixel (xStart,yStart)
+		const int ia[3] = { 1,2,0 };
+		const int ib[3] = { 2,0,1 };
+		long long e[3];
+		long long stepX[3];
+		long long stepY[3];
+		for( int i = 0; i < 3; i++ )
+		{
+			const long long dx = x[ib[i]] - x[ia[i]];
+			const long long dy = y[ib[i]] - y[ia[i]];
+			const long long px = (long long)xStart * subOne + subHalf - x[ia[i]];
+			const long long py = (long long)yStart * subOne + subHalf - y[ia[i]];
+			e[i] = dx * py - dy * px;
+			// centers exactly on a top or left edge are inside, on other edges outside
+			if( !(dy < 0 || (dy == 0 && dx > 0)) )
+			{
+				e[i] -= 1;
+			}
+			stepX[i] = -dy * subOne;
+			stepY[i] = dx * subOne;
+		}
+
+		// interpolation setup (barycentric weights of v1 and v2 are e[1] / area and e[2] / area)
+		const float areaInv = 1.0f / float( area );
+		const auto d10 = *pv1 - *pv0;
+		const auto d20 = *pv2 - *pv0;
+		const float dzdx = (d10.pos.z * float( stepX[1] ) + d20.pos.z * float( stepX[2] )) * areaInv;
+
+		for( int py = yStart; py < yEnd; py++,e[0] += stepY[0],e[1] += stepY[1],e[2] += stepY[2] )
+		{
+			// solve e[i] + k * stepX[i] >= 0 for the range of k that satisfies all 3 edges
+			long long kLo = 0;
+			long long kHi = xEnd - xStart - 1;
+			for( int i = 0; i < 3 && kLo <= kHi; i++ )
+			{
+				if( stepX[i] > 0 )
+				{
+					kLo = std::max( kLo,e[i] >= 0 ? 0 : (-e[i] + stepX[i] - 1) / stepX[i] );
+				}
+				else if( stepX[i] < 0 )
+				{
+					kHi = std::min( kHi,e[i] < 0 ? -1 : e[i] / -stepX[i] );
+				}
+				else if( e[i] < 0 )
+				{
+					kHi = -1;
+				}
+			}
+			if( kLo > kHi )
+			{
+				continue;
+			}
+			const int spanStart = xStart + int( kLo );
+			const int spanEnd = xStart + int( kHi ) + 1;
+
+			// edge values at the first pixel of the span
+			long long e1 = e[1] + kLo * stepX[1];
+			long long e2 = e[2] + kLo * stepX[2];
+
+			if constexpr( IsConstantShader<PixelShader>::value )
+			{
+				if( pZBuffer )
+				{
+					// depth at x = 0 from the exact edge values there, independent of the clip rect
+					const float zRow = pv0->pos.z + (d10.pos.z * float( e1 - spanStart * stepX[1] ) + d20.pos.z * float( e2 - spanStart * stepX[2] )) * areaInv;
+					FillSpanDepth( spanStart,spanEnd,py,zRow,dzdx,rc.ps.GetColor(),rc );
+				}
+				else
+				{
+					FillSpan( spanStart,spanEnd,py,rc.ps.GetColor() );
+				}
+			}
+			else
 			{
-				// invoke pixel shader with interpolated vertex attributes
-				// and use result to set the pixel color on the screen
-				gfx.PutPixel( x,y,effect.ps( iLine ) );
+				if( pZBuffer && pZBuffer->IsSpanOccluded( spanStart,spanEnd,py,rc.zMin ) )
+				{
+					continue;
+				}
+				for( int px = spanStart; px < spanEnd; px++,e1 += stepX[1],e2 += stepX[2] )
+				{
+					const auto attr = *pv0 + d10 * (float( e1 ) * areaInv) + d20 * (float( e2 ) * areaInv);
+					if( !pZBuffer || pZBuffer->TestAndSet( px,py,attr.pos.z ) )
+					{
+						gfx.PutPixel( px,py,rc.ps( PerspectiveCorrect( attr ) ) );
+					}
+				}
 			}
 		}
 	}
@@ -219,4 +1784,24 @@ public:
 private:
 	Graphics& gfx;
 	PubeScreenTransformer pst;
+	// same mapping as pst as an affine transform (normalized device space to screen, y flipped)
+	const Affine2 ndcToScreen = Affine2::ScaleTranslate( screenWidth / 2.0f,-screenHeight / 2.0f,screenWidth / 2.0f,screenHeight / 2.0f );
+	RasterMode rasterMode = RasterMode::Immediate;
+	RasterCore rasterCore = RasterCore::Scanline;
+	ZBuffer* pZBuffer = nullptr;
+	SpanBuffer* pSpanBuffer = nullptr;
+	MultisampleBuffer* pMultisampleBuffer = nullptr;
+	const RectI screenClip = { 0,int( Graphics::ScreenHeight ),0,int( Graphics::ScreenWidth ) };
+	static constexpr float screenWidth = float( Graphics::ScreenWidth );
+	static constexpr float screenHeight = float( Graphics::ScreenHeight );
+	// distance in pixels that triangles may extend past the screen before they get clipped
+	static constexpr float guardBand = 1024.0f;
+	int nTilesX;
+	int nTilesY;
+	std::vector<VSOut> vsScratch;
+	std::vector<BinnedTriangle> binnedTriangles;
+	std::vector<BinnedQuad> binnedQuads;
+	std::vector<std::vector<unsigned int>> bins;
+	size_t scratchGrowthCount = 0;
+	WorkerPool& workers;
 };
\ No newline at end of file
@@ -20,6 +20,18 @@ public:
 
 		return v;
 	}
+	// perspective divide of a clip space (Vec4 pos) vertex followed by the screen transform above
+	// every attribute is divided by w and pos.w is left holding 1/w,
+	// which makes them all interpolate linearly across the screen
+	template<class Vertex>
+	Vertex& TransformPerspective( Vertex& v ) const
+	{
+		const float wInv = 1.0f / v.pos.w;
+		v *= wInv;
+		v.pos.w = wInv;
+
+		return Transform( v );
+	}
 	template<class Vertex>
 	Vertex GetTransformed( const Vertex& v ) const
 	{
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "Colors.h"
+#include <immintrin.h>
+
+// block of floats processed in lockstep, one per pixel of a horizontal run
+// 8 lanes when compiling for AVX2 (the ReleaseAVX2 configuration, /arch:AVX2), 4 lanes (SSE) otherwise
+class FloatBlock
+{
+public:
+#ifdef __AVX2__
+	static constexpr int width = 8;
+	typedef __m256 Reg;
+#else
+	static constexpr int width = 4;
+	typedef __m128 Reg;
+#endif
+public:
+	FloatBlock() = default;
+	FloatBlock( Reg r )
+		:
+		r( r )
+	{}
+	// all lanes set to val
+	static FloatBlock Broadcast( float val )
+	{
+#ifdef __AVX2__
+		return _mm256_set1_ps( val );
+#else
+		return _mm_set1_ps( val );
+#endif
+	}
+	// lanes set to base,base + step,base + 2 * step...
+	static FloatBlock Ramp( float base,float step )
+	{
+#ifdef __AVX2__
+		return _mm256_add_ps( _mm256_set1_ps( base ),
+			_mm256_mul_ps( _mm256_set1_ps( step ),_mm256_setr_ps( 0.0f,1.0f,2.0f,3.0f,4.0f,5.0f,6.0f,7.0f ) ) );
+#else
+		return _mm_add_ps( _mm_set1_ps( base ),
+			_mm_mul_ps( _mm_set1_ps( step ),_mm_setr_ps( 0.0f,1.0f,2.0f,3.0f ) ) );
+#endif
+	}
+	FloatBlock& operator+=( const FloatBlock& rhs )
+	{
+#ifdef __AVX2__
+		r = _mm256_add_ps( r,rhs.r );
+#else
+		r = _mm_add_ps( r,rhs.r );
+#endif
+		return *this;
+	}
+	FloatBlock operator+( const FloatBlock& rhs ) const
+	{
+		return FloatBlock( *this ) += rhs;
+	}
+	FloatBlock& operator-=( const FloatBlock& rhs )
+	{
+#ifdef __AVX2__
+		r = _mm256_sub_ps( r,rhs.r );
+#else
+		r = _mm_sub_ps( r,rhs.r );
+#endif
+		return *this;
+	}
+	FloatBlock operator-( const FloatBlock& rhs ) const
+	{
+		return FloatBlock( *this ) -= rhs;
+	}
+	FloatBlock& operator*=( const FloatBlock& rhs )
+	{
+#ifdef __AVX2__
+		r = _mm256_mul_ps( r,rhs.r );
+#else
+		r = _mm_mul_ps( r,rhs.r );
+#endif
+		return *this;
+	}
+	FloatBlock operator*( const FloatBlock& rhs ) const
+	{
+		return FloatBlock( *this ) *= rhs;
+	}
+	// lanewise round down to a whole number (values must fit in an int)
+	FloatBlock Floor() const
+	{
+#ifdef __AVX2__
+		return _mm256_floor_ps( r );
+#else
+		// truncate, then step down the lanes where truncation went up (negative non-integers)
+		const __m128 t = _mm_cvtepi32_ps( _mm_cvttps_epi32( r ) );
+		return _mm_sub_ps( t,_mm_and_ps( _mm_cmpgt_ps( t,r ),_mm_set1_ps( 1.0f ) ) );
+#endif
+	}
+	// lanewise round up to a whole number (values must fit in an int)
+	FloatBlock Ceil() const
+	{
+#ifdef __AVX2__
+		return _mm256_ceil_ps( r );
+#else
+		// truncate, then step up the lanes where truncation went down (positive non-integers)
+		const __m128 t = _mm_cvtepi32_ps( _mm_cvttps_epi32( r ) );
+		return _mm_add_ps( t,_mm_and_ps( _mm_cmplt_ps( t,r ),_mm_set1_ps( 1.0f ) ) );
+#endif
+	}
+	FloatBlock Min( const FloatBlock& rhs ) const
+	{
+#ifdef __AVX2__
+		return _mm256_min_ps( r,rhs.r );
+#else
+		return _mm_min_ps( r,rhs.r );
+#endif
+	}
+	FloatBlock Max( const FloatBlock& rhs ) const
+	{
+#ifdef __AVX2__
+		return _mm256_max_ps( r,rhs.r );
+#else
+		return _mm_max_ps( r,rhs.r );
+#endif
+	}
+	// lanewise clamp to [lo,hi]
+	FloatBlock Clamp( float lo,float hi ) const
+	{
+#ifdef __AVX2__
+		return _mm256_min_ps( _mm256_max_ps( r,_mm256_set1_ps( lo ) ),_mm256_set1_ps( hi ) );
+#else
+		return _mm_min_ps( _mm_max_ps( r,_mm_set1_ps( lo ) ),_mm_set1_ps( hi ) );
+#endif
+	}
+	// bitmask (lane i -> bit i) of lanes where this >= rhs
+	int MaskGreaterEqual( const FloatBlock& rhs ) const
+	{
+#ifdef __AVX2__
+		return _mm256_movemask_ps( _mm256_cmp_ps( r,rhs.r,_CMP_GE_OQ ) );
+#else
+		return _mm_movemask_ps( _mm_cmpge_ps( r,rhs.r ) );
+#endif
+	}
+	// bitmask (lane i -> bit i) of lanes where this > rhs
+	int MaskGreater( const FloatBlock& rhs ) const
+	{
+#ifdef __AVX2__
+		return _mm256_movemask_ps( _mm256_cmp_ps( r,rhs.r,_CMP_GT_OQ ) );
+#else
+		return _mm_movemask_ps( _mm_cmpgt_ps( r,rhs.r ) );
+#endif
+	}
+	// copy lanes out to memory
+	void Store( float* pOut ) const
+	{
+#ifdef __AVX2__
+		_mm256_storeu_ps( pOut,r );
+#else
+		_mm_storeu_ps( pOut,r );
+#endif
+	}
+	// first count lanes from floats stride bytes apart (members of an array of structs),
+	// lanes past count are 0
+	static FloatBlock LoadStrided( const float* pFirst,size_t stride,int count )
+	{
+		const char* p = reinterpret_cast<const char*>(pFirst);
+		const auto lane = [p,stride]( int i )
+		{
+			return *reinterpret_cast<const float*>(p + i * stride);
+		};
+		// full blocks go straight into the register, no round trip through memory
+		if( count == width )
+		{
+#ifdef __AVX2__
+			return _mm256_setr_ps( lane( 0 ),lane( 1 ),lane( 2 ),lane( 3 ),lane( 4 ),lane( 5 ),lane( 6 ),lane( 7 ) );
+#else
+			return _mm_setr_ps( lane( 0 ),lane( 1 ),lane( 2 ),lane( 3 ) );
+#endif
+		}
+		alignas(32) float lanes[width] = {};
+		for( int i = 0; i < count; i++ )
+		{
+			lanes[i] = lane( i );
+		}
+#ifdef __AVX2__
+		return _mm256_load_ps( lanes );
+#else
+		return _mm_load_ps( lanes );
+#endif
+	}
+	// first count lanes out to floats stride bytes apart
+	void StoreStrided( float* pFirst,size_t stride,int count ) const
+	{
+		alignas(32) float lanes[width];
+#ifdef __AVX2__
+		_mm256_store_ps( lanes,r );
+#else
+		_mm_store_ps( lanes,r );
+#endif
+		char* p = reinterpret_cast<char*>(pFirst);
+		for( int i = 0; i < count; i++,p += stride )
+		{
+			*reinterpret_cast<float*>(p) = lanes[i];
+		}
+	}
+public:
+	Reg r;
+};
+
+// block of 32-bit integers matching FloatBlock lane for lane
+// (only what the texture sampler needs: conversion, gathering and unpacking color channels)
+class IntBlock
+{
+public:
+#ifdef __AVX2__
+	typedef __m256i Reg;
+#else
+	typedef __m128i Reg;
+#endif
+public:
+	IntBlock() = default;
+	IntBlock( Reg r )
+		:
+		r( r )
+	{}
+	// converts by truncation
+	static IntBlock FromFloat( const FloatBlock& f )
+	{
+#ifdef __AVX2__
+		return _mm256_cvttps_epi32( f.r );
+#else
+		return _mm_cvttps_epi32( f.r );
+#endif
+	}
+	// lane i loaded from pBase[index lane i]
+	static IntBlock Gather( const unsigned int* pBase,const IntBlock& index )
+	{
+#ifdef __AVX2__
+		return _mm256_i32gather_epi32( reinterpret_cast<const int*>(pBase),index.r,4 );
+#else
+		alignas(16) int i[4];
+		_mm_store_si128( reinterpret_cast<__m128i*>(i),index.r );
+		return _mm_setr_epi32( int( pBase[i[0]] ),int( pBase[i[1]] ),int( pBase[i[2]] ),int( pBase[i[3]] ) );
+#endif
+	}
+	// (lane >> shift) & 0xFF as float, pulls one 8-bit channel out of packed colors
+	FloatBlock Channel( int shift ) const
+	{
+#ifdef __AVX2__
+		return _mm256_cvtepi32_ps( _mm256_and_si256( _mm256_srl_epi32( r,_mm_cvtsi32_si128( shift ) ),_mm256_set1_epi32( 0xFF ) ) );
+#else
+		return _mm_cvtepi32_ps( _mm_and_si128( _mm_srl_epi32( r,_mm_cvtsi32_si128( shift ) ),_mm_set1_epi32( 0xFF ) ) );
+#endif
+	}
+public:
+	Reg r;
+};
+
+// converts blocks of r,g,b channel values (0-255, truncated like Color( Vec3 ) does)
+// to FloatBlock::width packed colors
+inline void StoreColors( const FloatBlock& r,const FloatBlock& g,const FloatBlock& b,Color* pOut )
+{
+#ifdef __AVX2__
+	const __m256i ri = _mm256_cvttps_epi32( r.Clamp( 0.0f,255.0f ).r );
+	const __m256i gi = _mm256_cvttps_epi32( g.Clamp( 0.0f,255.0f ).r );
+	const __m256i bi = _mm256_cvttps_epi32( b.Clamp( 0.0f,255.0f ).r );
+	_mm256_storeu_si256( reinterpret_cast<__m256i*>(pOut),
+		_mm256_or_si256( _mm256_or_si256( _mm256_slli_epi32( ri,16 ),_mm256_slli_epi32( gi,8 ) ),bi ) );
+#else
+	const __m128i ri = _mm_cvttps_epi32( r.Clamp( 0.0f,255.0f ).r );
+	const __m128i gi = _mm_cvttps_epi32( g.Clamp( 0.0f,255.0f ).r );
+	const __m128i bi = _mm_cvttps_epi32( b.Clamp( 0.0f,255.0f ).r );
+	_mm_storeu_si128( reinterpret_cast<__m128i*>(pOut),
+		_mm_or_si128( _mm_or_si128( _mm_slli_epi32( ri,16 ),_mm_slli_epi32( gi,8 ) ),bi ) );
+#endif
+}
\ No newline at end of file
@@ -3,12 +3,15 @@
 #include "Pipeline.h"
 #include "DefaultGeometryShader.h"
 #include "Mat2.h"
+#include "Affine2.h"
 #include "Camera.h"
 
 // solid color attribute not interpolated
 class SolidEffect
 {
 public:
+	// 2D only, pipeline takes the affine path (see IsAffine2D)
+	static constexpr bool isAffine2D = true;
 	// the vertex type that will be input into the pipeline
 	using Vertex = Vec2;
 	// default vs rotates and translates vertices
@@ -82,14 +85,30 @@ public:
 		{
 			translation = translation_in;
 		}
+		// layer depth written to z (smaller is closer when depth testing)
+		void BindDepth( float depth_in )
+		{
+			depth = depth_in;
+		}
 		Output operator()( const SolidEffect::Vertex& in ) const
 		{
 			const Vec2 xformd = (in * rotation + translation + cam.GetTranslation()) * cam.GetZoom();
-			return{ {xformd.x,xformd.y,1.0f} };
+			return{ {xformd.x,xformd.y,depth} };
+		}
+		// model to normalized device space, for the pipeline's 2D affine path
+		Affine2 GetTransform() const
+		{
+			return{ rotation * cam.GetZoom(),(translation + cam.GetTranslation()) * cam.GetZoom() };
+		}
+		Output operator()( const SolidEffect::Vertex& in,const Affine2& modelToScreen ) const
+		{
+			const Vec2 xformd = in * modelToScreen;
+			return{ {xformd.x,xformd.y,depth} };
 		}
 	private:
 		Mat2 rotation;
 		Vec2 translation;
+		float depth = 1.0f;
 	};
 	// default gs passes vertices through and outputs triangle
 	typedef DefaultGeometryShader<VertexShader::Output> GeometryShader;
@@ -99,11 +118,18 @@ public:
 	// and outputs a color
 	class PixelShader
 	{
+	public:
+		// output never depends on the input, lets the pipeline fill spans directly
+		static constexpr bool isConstant = true;
 	public:
 		void BindColor( Color c )
 		{
 			color = c;
 		}
+		Color GetColor() const
+		{
+			return color;
+		}
 		template<class I>
 		Color operator()( const I& in ) const
 		{
@@ -112,6 +138,27 @@ public:
 	private:
 		Color color;
 	};
+	// per-instance state for instanced draws
+	class Instance
+	{
+	public:
+		Mat2 rotation;
+		Vec2 translation;
+		Color color;
+		// radius of a circle around translation that contains the whole transformed model
+		float boundingRadius;
+	};
+public:
+	bool IsInstanceVisible( const Instance& inst ) const
+	{
+		return vs.cam.Overlaps( inst.translation,inst.boundingRadius );
+	}
+	void BindInstance( const Instance& inst )
+	{
+		vs.BindRotation( inst.rotation );
+		vs.BindTranslation( inst.translation );
+		ps.BindColor( inst.color );
+	}
 public:
 	VertexShader vs;
 	GeometryShader gs;
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+// per-scanline lists of the x intervals already covered by opaque spans this frame
+// lets opaque geometry drawn front to back fill only the gaps that are still open,
+// so every pixel is written about once without keeping a per-pixel depth
+// rows are split into columns of columnWidth pixels with a list each, so that threads working
+// on tiles of (a multiple of) columnWidth pixels never share a list
+class SpanBuffer
+{
+public:
+	static constexpr int columnWidth = 64;
+public:
+	SpanBuffer( int width,int height )
+		:
+		width( width ),
+		height( height ),
+		nColumns( (width + columnWidth - 1) / columnWidth ),
+		rows( nColumns * height )
+	{}
+	SpanBuffer( const SpanBuffer& ) = delete;
+	SpanBuffer& operator=( const SpanBuffer& ) = delete;
+	// lists keep their capacity, so steady state frames don't allocate
+	void Clear()
+	{
+		for( auto& row : rows )
+		{
+			row.clear();
+		}
+	}
+	// calls fill( xStart,xEnd ) for every part of [xStart,xEnd) on row y that isn't covered yet
+	// and marks the whole span covered
+	template<class F>
+	void Cover( int xStart,int xEnd,int y,F&& fill )
+	{
+		assert( xStart >= 0 );
+		assert( xEnd <= width );
+		assert( y >= 0 );
+		assert( y < height );
+		for( int col = xStart / columnWidth; xStart < xEnd; col++ )
+		{
+			const int colEnd = std::min( xEnd,(col + 1) * columnWidth );
+			CoverInColumn( rows[y * nColumns + col],xStart,colEnd,fill );
+			xStart = colEnd;
+		}
+	}
+	int GetWidth() const
+	{
+		return width;
+	}
+	int GetHeight() const
+	{
+		return height;
+	}
+private:
+	// half open [start,end), lists are sorted and intervals never overlap or touch
+	struct Interval
+	{
+		int start;
+		int end;
+	};
+private:
+	template<class F>
+	static void CoverInColumn( std::vector<Interval>& row,int xStart,int xEnd,F& fill )
+	{
+		// first interval that overlaps or touches the span
+		auto it = std::lower_bound( row.begin(),row.end(),xStart,[]( const Interval& i,int x )
+		{
+			return i.end < x;
+		} );
+		const auto first = it;
+		Interval merged = { xStart,xEnd };
+		int x = xStart;
+		for( ; it != row.end() && it->start <= xEnd; ++it )
+		{
+			if( it->start > x )
+			{
+				fill( x,it->start );
+			}
+			x = std::max( x,it->end );
+			merged.start = std::min( merged.start,it->start );
+			merged.end = std::max( merged.end,it->end );
+		}
+		if( x < xEnd )
+		{
+			fill( x,xEnd );
+		}
+		// intervals the span touched collapse into one
+		if( first == it )
+		{
+			row.insert( first,merged );
+		}
+		else
+		{
+			*first = merged;
+			row.erase( first + 1,it );
+		}
+	}
+private:
+	int width;
+	int height;
+	int nColumns;
+	std::vector<std::vector<Interval>> rows;
+};
\ No newline at end of file
@@ -22,15 +22,24 @@
 #include "ChiliWin.h"
 #include "Surface.h"
 #include "ChiliException.h"
+#include <sstream>
+#include <cstring>
+#ifdef CHILI_HEADLESS
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <vector>
+#else
 namespace Gdiplus
 {
 	using std::min;
 	using std::max;
 }
 #include <gdiplus.h>
-#include <sstream>
 
 #pragma comment( lib,"gdiplus.lib" )
+#endif
 
 void Surface::PutPixelAlpha( unsigned int x,unsigned int y,Color c )
 {
@@ -38,54 +47,171 @@ void Surface::PutPixelAlpha( unsigned int x,unsigned int y,Color c )
 	assert( y >= 0 );
 	assert( x < width );
 	assert( y < height );
-	// load source pixel
-	const Color d = GetPixel( x,y );
+	// blend with the destination pixel and fire result onto surface
+	PutPixel( x,y,Blend( c,GetPixel( x,y ) ) );
+}
+
+#ifdef CHILI_HEADLESS
+// no gdi+, bitmaps are read and written by hand: uncompressed 24/32 bit bmp only
+namespace
+{
+	constexpr size_t bmpHeaderSize = 14u + 40u; // file header + BITMAPINFOHEADER
 
-	// blend channels
-	const unsigned char rsltRed = (c.GetR() * c.GetA() + d.GetR() * (255u - c.GetA())) / 256u;
-	const unsigned char rsltGreen = (c.GetG() * c.GetA() + d.GetG() * (255u - c.GetA())) / 256u;
-	const unsigned char rsltBlue = (c.GetB() * c.GetA() + d.GetB() * (255u - c.GetA())) / 256u;
+	unsigned int ReadLE( const unsigned char* p,int nBytes )
+	{
+		unsigned int value = 0u;
+		for( int i = nBytes - 1; i >= 0; i-- )
+		{
+			value = (value << 8u) | p[i];
+		}
+		return value;
+	}
 
-	// pack channels back into pixel and fire pixel onto surface
-	PutPixel( x,y,{ rsltRed,rsltGreen,rsltBlue } );
+	void WriteLE( unsigned char* p,unsigned int value,int nBytes )
+	{
+		for( int i = 0; i < nBytes; i++ )
+		{
+			p[i] = (unsigned char)(value >> (8 * i));
+		}
+	}
 }
 
 Surface Surface::FromFile( const std::wstring & name )
 {
-	unsigned int width = 0;
-	unsigned int height = 0;
-	unsigned int pitch = 0;
-	std::unique_ptr<Color[]> pBuffer = nullptr;
+	const auto Fail = [&name]( const wchar_t* what )
+	{
+		std::wstringstream ss;
+		ss << L"Loading image [" << name << L"]: " << what;
+		return Exception( _CRT_WIDE( __FILE__ ),__LINE__,ss.str() );
+	};
 
+	std::ifstream file( std::filesystem::path( name ),std::ios::binary );
+	if( !file )
 	{
-		Gdiplus::Bitmap bitmap( name.c_str() );
-		if( bitmap.GetLastStatus() != Gdiplus::Status::Ok )
+		throw Fail( L"failed to load." );
+	}
+	const std::vector<unsigned char> data{ std::istreambuf_iterator<char>( file ),std::istreambuf_iterator<char>() };
+	if( data.size() < bmpHeaderSize || data[0] != 'B' || data[1] != 'M' )
+	{
+		throw Fail( L"not a bmp (nothing else can be loaded headless)." );
+	}
+
+	const size_t offset = ReadLE( &data[10],4 );
+	const int width = int( ReadLE( &data[18],4 ) );
+	const int rawHeight = int( ReadLE( &data[22],4 ) );
+	const unsigned int bpp = ReadLE( &data[28],2 );
+	const unsigned int compression = ReadLE( &data[30],4 );
+	// bitfields only as written for 32 bit argb (masks taken to be the usual bgra)
+	const bool hasAlpha = bpp == 32u && compression == 3u;
+	if( (bpp != 24u && bpp != 32u) || (compression != 0u && !hasAlpha) || width <= 0 || rawHeight == 0 )
+	{
+		throw Fail( L"unsupported bmp format (24/32 bit uncompressed only)." );
+	}
+	// negative height is stored top down
+	const int height = std::abs( rawHeight );
+	const size_t bytesPerPixel = bpp / 8u;
+	const size_t rowSize = (width * bytesPerPixel + 3u) & ~size_t( 3u );
+	if( offset + rowSize * height > data.size() )
+	{
+		throw Fail( L"file is truncated." );
+	}
+
+	Surface surface( width,height );
+	for( int y = 0; y < height; y++ )
+	{
+		const unsigned char* pRow = &data[offset + rowSize * (rawHeight < 0 ? y : height - 1 - y)];
+		for( int x = 0; x < width; x++ )
 		{
-			std::wstringstream ss;
-			ss << L"Loading image [" << name << L"]: failed to load.";
-			throw Exception( _CRT_WIDE( __FILE__ ),__LINE__,ss.str() );
+			const unsigned char* p = &pRow[x * bytesPerPixel];
+			surface.PutPixel( x,y,{ hasAlpha ? p[3] : (unsigned char)(255u),p[2],p[1],p[0] } );
 		}
+	}
+
+	return surface;
+}
 
-		pitch = width = bitmap.GetWidth();
-		height = bitmap.GetHeight();
-		pBuffer = std::make_unique<Color[]>( width * height );
+void Surface::Save( const std::wstring & filename ) const
+{
+	std::vector<Color> bitmap = MakeBitmap( width,height );
+	Surface( GetBitmapView( bitmap,width,height ) ).Copy( *this );
+	SaveBitmap( filename,bitmap );
+}
+
+std::vector<Color> Surface::MakeBitmap( unsigned int width,unsigned int height )
+{
+	static_assert(bitmapPixelOffset >= bmpHeaderSize && bitmapPixelOffset % sizeof( Color ) == 0,
+		"pixels have to start on a whole Color past the header");
+	// 32 bit rows are never padded and have the same bytes as a Color
+	const size_t pixelSize = size_t( width ) * height * sizeof( Color );
+	std::vector<Color> bitmap( (bitmapPixelOffset + pixelSize) / sizeof( Color ) );
+	unsigned char* const data = reinterpret_cast<unsigned char*>(bitmap.data());
+	data[0] = 'B';
+	data[1] = 'M';
+	WriteLE( &data[2],(unsigned int)(bitmapPixelOffset + pixelSize),4 );
+	WriteLE( &data[10],(unsigned int)(bitmapPixelOffset),4 );
+	WriteLE( &data[14],40u,4 );
+	WriteLE( &data[18],width,4 );
+	// negative height: rows top down, like a linear surface
+	WriteLE( &data[22],(unsigned int)(-int( height )),4 );
+	WriteLE( &data[26],1u,2 );
+	WriteLE( &data[28],32u,2 );
+	WriteLE( &data[34],(unsigned int)(pixelSize),4 );
+	return bitmap;
+}
+
+SurfaceView Surface::GetBitmapView( std::vector<Color>& bitmap,unsigned int width,unsigned int height )
+{
+	assert( bitmap.size() * sizeof( Color ) == bitmapPixelOffset + size_t( width ) * height * sizeof( Color ) );
+	return{ &bitmap[bitmapPixelOffset / sizeof( Color )],width,height,width };
+}
 
-		for( unsigned int y = 0; y < height; y++ )
+void Surface::SaveBitmap( const std::wstring& filename,const std::vector<Color>& bitmap )
+{
+	std::ofstream file( std::filesystem::path( filename ),std::ios::binary );
+	file.write( reinterpret_cast<const char*>(bitmap.data()),std::streamsize( bitmap.size() * sizeof( Color ) ) );
+	if( !file )
+	{
+		std::wstringstream ss;
+		ss << L"Saving surface to [" << filename << L"]: failed to save.";
+		throw Exception( _CRT_WIDE( __FILE__ ),__LINE__,ss.str() );
+	}
+}
+#else
+Surface Surface::FromFile( const std::wstring & name )
+{
+	Gdiplus::Bitmap bitmap( name.c_str() );
+	if( bitmap.GetLastStatus() != Gdiplus::Status::Ok )
+	{
+		std::wstringstream ss;
+		ss << L"Loading image [" << name << L"]: failed to load.";
+		throw Exception( _CRT_WIDE( __FILE__ ),__LINE__,ss.str() );
+	}
+
+	Surface surface( bitmap.GetWidth(),bitmap.GetHeight() );
+	for( unsigned int y = 0; y < surface.height; y++ )
+	{
+		for( unsigned int x = 0; x < surface.width; x++ )
 		{
-			for( unsigned int x = 0; x < width; x++ )
-			{
-				Gdiplus::Color c;
-				bitmap.GetPixel( x,y,&c );
-				pBuffer[y * pitch + x] = c.GetValue();
-			}
+			Gdiplus::Color c;
+			bitmap.GetPixel( x,y,&c );
+			surface.PutPixel( x,y,c.GetValue() );
 		}
 	}
 
-	return Surface( width,height,pitch,std::move( pBuffer ) );
+	return surface;
 }
 
 void Surface::Save( const std::wstring & filename ) const
 {
+	// gdi+ wants the pixels row after row
+	if( layout != Layout::Linear )
+	{
+		Surface linear( width,height );
+		linear.Copy( *this );
+		linear.Save( filename );
+		return;
+	}
+
 	auto GetEncoderClsid = [&filename]( const WCHAR* format,CLSID* pClsid ) -> void
 	{
 		UINT  num = 0;          // number of image encoders
@@ -130,7 +256,7 @@ void Surface::Save( const std::wstring & filename ) const
 
 	CLSID bmpID;
 	GetEncoderClsid( L"image/bmp",&bmpID );
-	Gdiplus::Bitmap bitmap( width,height,pitch * sizeof( Color ),PixelFormat32bppARGB,(BYTE*)pBuffer.get() );
+	Gdiplus::Bitmap bitmap( width,height,pitch * sizeof( Color ),PixelFormat32bppARGB,(BYTE*)pBuffer );
 	if( bitmap.Save( filename.c_str(),&bmpID,nullptr ) != Gdiplus::Status::Ok )
 	{
 		std::wstringstream ss;
@@ -138,20 +264,22 @@ void Surface::Save( const std::wstring & filename ) const
 		throw Exception( _CRT_WIDE( __FILE__ ),__LINE__,ss.str() );
 	}
 }
+#endif
 
 void Surface::Copy( const Surface & src )
 {
 	assert( width == src.width );
 	assert( height == src.height );
-	if( pitch == src.pitch )
+	// one bulk copy covers the row padding (and the padded rows of the tiled layout), which is only
+	// ours to write when both buffers are our own allocations or the rows have no padding at all
+	// a view's padding can belong to somebody else, or lie past the end of its mapping
+	if( layout == src.layout && pitch == src.pitch &&
+		((OwnsBuffer() && src.OwnsBuffer()) || pitch == width) )
 	{
-		memcpy( pBuffer.get(),src.pBuffer.get(),pitch * height * sizeof( Color ) );
+		CopyPixels( pBuffer,src.pBuffer,int( pitch * GetPaddedHeight( height,layout ) ) );
 	}
 	else
 	{
-		for( unsigned int y = 0; y < height; y++ )
-		{
-			memcpy( &pBuffer[pitch * y],&src.pBuffer[pitch * y],sizeof( Color )* width );
-		}
+		Blit( src,0,0 );
 	}
 }
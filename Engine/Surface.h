@@ -22,10 +22,15 @@
 #include "ChiliWin.h"
 #include "Colors.h"
 #include "Rect.h"
+#include "SurfaceView.h"
 #include "ChiliException.h"
 #include <string>
 #include <assert.h>
 #include <memory>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <emmintrin.h>
 
 
 class Surface
@@ -38,65 +43,221 @@ public:
 		virtual std::wstring GetFullMessage() const override { return GetNote() + L"\nAt: " + GetLocation(); }
 		virtual std::wstring GetExceptionType() const override { return L"Surface Exception"; }
 	};
+public:
+	// how pixels are arranged in memory
+	//   Linear: row after row, pitch pixels apart
+	//   Tiled: blockSize x blockSize pixel blocks, block after block along a row of blocks, row after row
+	//     inside a block, so that a few rows of a narrow area share cache lines (rows are padded to
+	//     whole blocks); meant for render targets, Present detiles on the way out
+	// the layout is invisible to users of the pixel and span functions, only the raw buffer
+	// (GetBufferPtr) needs the linear layout
+	enum class Layout
+	{
+		Linear,
+		Tiled
+	};
+	static constexpr unsigned int blockSize = 8;
 public:
 	Surface( unsigned int width,unsigned int height,unsigned int pitch )
 		:
-		pBuffer( std::make_unique<Color[]>( pitch * height ) ),
-		width( width ),
-		height( height ),
-		pitch( pitch )
+		Surface( width,height,pitch,Layout::Linear )
 	{}
+	// rows padded to whole cache lines
 	Surface( unsigned int width,unsigned int height )
 		:
-		Surface( width,height,width )
+		Surface( width,height,Layout::Linear )
+	{}
+	// tiled rows are padded to whole blocks
+	Surface( unsigned int width,unsigned int height,Layout layout )
+		:
+		Surface( width,height,
+			GetPitch( width,layout == Layout::Tiled ? blockSize * unsigned( sizeof( Color ) ) : cacheLineSize ),layout )
 	{}
+	// draws straight into the view's memory instead of owning a buffer (linear layout)
+	explicit Surface( const SurfaceView& view )
+		:
+		pBuffer( view.pPixels ),
+		width( view.width ),
+		height( view.height ),
+		pitch( view.pitch ),
+		layout( Layout::Linear )
+	{
+		assert( pBuffer != nullptr || width * height == 0 );
+	}
 	Surface( Surface&& source )
 		:
-		pBuffer( std::move( source.pBuffer ) ),
+		pStorage( std::move( source.pStorage ) ),
+		pBuffer( source.pBuffer ),
 		width( source.width ),
 		height( source.height ),
-		pitch( source.pitch )
-	{}
+		pitch( source.pitch ),
+		layout( source.layout )
+	{
+		source.pBuffer = nullptr;
+	}
 	Surface( Surface& ) = delete;
 	Surface& operator=( Surface&& donor )
 	{
 		width = donor.width;
 		height = donor.height;
 		pitch = donor.pitch;
-		pBuffer = std::move( donor.pBuffer );
+		layout = donor.layout;
+		pStorage = std::move( donor.pStorage );
+		pBuffer = donor.pBuffer;
 		donor.pBuffer = nullptr;
 		return *this;
 	}
 	Surface& operator=( const Surface& ) = delete;
 	~Surface()
 	{}
-	void Clear( Color fillValue  )
+	// fills the whole buffer with c (regular stores, the frame drawn next wants it in the cache)
+	void Clear( Color fillValue )
 	{
-		memset( pBuffer.get(),fillValue.dword,pitch * height * sizeof( Color ) );
+		if( OwnsBuffer() || pitch == width )
+		{
+			FillPixels( pBuffer,size_t( pitch ) * GetPaddedHeight( height,layout ),fillValue );
+		}
+		else
+		{
+			// the padding of a view isn't ours to touch
+			for( unsigned int y = 0; y < height; y++ )
+			{
+				FillPixels( &pBuffer[size_t( pitch ) * y],width,fillValue );
+			}
+		}
 	}
+	// copies the pixels to pDst (linear, rows dstPitch BYTES apart), streamed past the cache since
+	// the destination is mapped adapter memory that is never read back
 	void Present( unsigned int dstPitch,BYTE* const pDst ) const
 	{
 		for( unsigned int y = 0; y < height; y++ )
 		{
-			memcpy( &pDst[dstPitch * y],&pBuffer[pitch * y],sizeof(Color) * width );
+			Color* const pDstRow = reinterpret_cast<Color*>(&pDst[size_t( dstPitch ) * y]);
+			ForEachRun( 0u,width,y,[pDstRow]( const Color* pRun,unsigned int x,unsigned int n )
+			{
+				StreamCopy( pDstRow + x,pRun,n );
+			} );
+		}
+		_mm_sfence();
+	}
+	// fills the part of rect that is on the surface with c
+	void FillRect( RectI rect,Color c )
+	{
+		rect.ClipTo( GetRect() );
+		if( rect.GetWidth() <= 0 )
+		{
+			return;
+		}
+		for( int y = rect.top; y < rect.bottom; y++ )
+		{
+			FillSpan( rect.left,rect.right,y,c );
+		}
+	}
+	// copies srcRect of src to the pixels starting at x,y, clipped to both surfaces
+	// src must not be this surface
+	void Blit( const Surface& src,RectI srcRect,int x,int y )
+	{
+		assert( &src != this );
+		// offset from destination to source pixels
+		const int dx = srcRect.left - x;
+		const int dy = srcRect.top - y;
+		srcRect.ClipTo( src.GetRect() );
+		// the part of the source that lands on this surface
+		RectI dstRect = srcRect;
+		dstRect.Translate( -dx,-dy );
+		dstRect.ClipTo( GetRect() );
+		if( dstRect.GetWidth() <= 0 )
+		{
+			return;
+		}
+		for( int yd = dstRect.top; yd < dstRect.bottom; yd++ )
+		{
+			// runs contiguous in both surfaces
+			ForEachRun( dstRect.left,dstRect.right,yd,[&src,dx,yd,dy]( Color* pDstRun,unsigned int x,unsigned int n )
+			{
+				src.ForEachRun( x + dx,x + dx + n,yd + dy,[pDstRun,x,dx]( const Color* pSrcRun,unsigned int xs,unsigned int ns )
+				{
+					CopyPixels( pDstRun + (xs - dx - x),pSrcRun,ns );
+				} );
+			} );
 		}
 	}
+	void Blit( const Surface& src,int x,int y )
+	{
+		Blit( src,src.GetRect(),x,y );
+	}
 	void PutPixel( unsigned int x,unsigned int y,Color c )
 	{
 		assert( x >= 0 );
 		assert( y >= 0 );
 		assert( x < width );
 		assert( y < height );
-		pBuffer[y * pitch + x] = c;
+		pBuffer[Index( x,y )] = c;
+	}
+	// writes the pixels [x,x + count) of row y for which the corresponding bit of mask is set
+	// (colors are read from pColors[0..count), whole runs of 4 are written with a single store)
+	void PutPixelsMasked( unsigned int x,unsigned int y,const Color* pColors,unsigned int mask,unsigned int count )
+	{
+		assert( x + count <= width );
+		assert( y < height );
+		ForEachRun( x,x + count,y,[x,pColors,mask]( Color* pRun,unsigned int xr,unsigned int n )
+		{
+			StoreMasked( pRun,pColors + (xr - x),mask >> (xr - x),n );
+		} );
+	}
+	// fills pixels [xStart,xEnd) of row y with c, 4 pixels per (aligned) store
+	void FillSpan( unsigned int xStart,unsigned int xEnd,unsigned int y,Color c )
+	{
+		assert( xStart <= xEnd );
+		assert( xEnd <= width );
+		assert( y < height );
+		ForEachRun( xStart,xEnd,y,[c]( Color* pRun,unsigned int,unsigned int n )
+		{
+			FillPixels( pRun,n,c );
+		} );
 	}
 	void PutPixelAlpha( unsigned int x,unsigned int y,Color c );
+	// alpha composites c over pixels [xStart,xEnd) of row y, 4 pixels at a time
+	// (same result as PutPixelAlpha on every pixel)
+	void BlendSpan( unsigned int xStart,unsigned int xEnd,unsigned int y,Color c )
+	{
+		assert( xStart <= xEnd );
+		assert( xEnd <= width );
+		assert( y < height );
+		ForEachRun( xStart,xEnd,y,[c]( Color* pRun,unsigned int,unsigned int n )
+		{
+			BlendPixels( pRun,n,c );
+		} );
+	}
+	// alpha composites c over the part of rect that is on the surface
+	void BlendRect( RectI rect,Color c )
+	{
+		rect.ClipTo( GetRect() );
+		if( rect.GetWidth() <= 0 )
+		{
+			return;
+		}
+		for( int y = rect.top; y < rect.bottom; y++ )
+		{
+			BlendSpan( rect.left,rect.right,y,c );
+		}
+	}
+	// c composited over d with c's alpha, x of the result is 0
+	static Color Blend( Color c,Color d )
+	{
+		const unsigned int a = c.GetA();
+		return{
+			(unsigned char)((c.GetR() * a + d.GetR() * (255u - a)) / 256u),
+			(unsigned char)((c.GetG() * a + d.GetG() * (255u - a)) / 256u),
+			(unsigned char)((c.GetB() * a + d.GetB() * (255u - a)) / 256u) };
+	}
 	Color GetPixel( unsigned int x,unsigned int y ) const
 	{
 		assert( x >= 0 );
 		assert( y >= 0 );
 		assert( x < width );
 		assert( y < height );
-		return pBuffer[y * pitch + x];
+		return pBuffer[Index( x,y )];
 	}
 	unsigned int GetWidth() const
 	{
@@ -106,22 +267,211 @@ public:
 	{
 		return height;
 	}
+	// in pixels, for the tiled layout the width padded to whole blocks
 	unsigned int GetPitch() const
 	{
 		return pitch;
 	}
+	Layout GetLayout() const
+	{
+		return layout;
+	}
+	RectI GetRect() const
+	{
+		return { 0,int( height ),0,int( width ) };
+	}
+	// the pixels as a view for others to draw into or read from, linear layout only
+	// (valid while this surface and its buffer live)
+	SurfaceView GetView()
+	{
+		assert( layout == Layout::Linear );
+		return{ pBuffer,width,height,pitch };
+	}
+	// true if the buffer is this surface's own, false when made from a view
+	bool OwnsBuffer() const
+	{
+		return pStorage != nullptr;
+	}
+	// raw pixels, linear layout only
 	Color* GetBufferPtr()
 	{
-		return pBuffer.get();
+		assert( layout == Layout::Linear );
+		return pBuffer;
 	}
 	const Color* GetBufferPtrConst() const
 	{
-		return pBuffer.get();
+		assert( layout == Layout::Linear );
+		return pBuffer;
 	}
 	static Surface FromFile( const std::wstring& name );
 	void Save( const std::wstring& filename ) const;
+#ifdef CHILI_HEADLESS
+	// image of a 32 bit top down bmp file: the header, then width x height pixels without row padding
+	// from bitmapPixelOffset bytes on, so a SurfaceView can draw into it and SaveBitmap writes it as is
+	static constexpr size_t bitmapPixelOffset = 64u;
+	static std::vector<Color> MakeBitmap( unsigned int width,unsigned int height );
+	static SurfaceView GetBitmapView( std::vector<Color>& bitmap,unsigned int width,unsigned int height );
+	static void SaveBitmap( const std::wstring& filename,const std::vector<Color>& bitmap );
+#endif
+	// copies all pixels of src (same dimensions, any layout)
 	void Copy( const Surface& src );
 private:
+	// storage unit, keeps the buffer cache line aligned (and with it rows whose pitch is
+	// a multiple of 16 pixels, and every block of the tiled layout)
+	static constexpr unsigned int cacheLineSize = 64;
+	struct alignas(cacheLineSize) CacheLine
+	{
+		Color pixels[cacheLineSize / sizeof( Color )];
+	};
+	static std::unique_ptr<CacheLine[]> Allocate( size_t nPixels )
+	{
+		constexpr size_t pixelsPerLine = cacheLineSize / sizeof( Color );
+		return std::make_unique<CacheLine[]>( (nPixels + pixelsPerLine - 1) / pixelsPerLine );
+	}
+	// rows in the buffer (the tiled layout always has whole blocks)
+	static unsigned int GetPaddedHeight( unsigned int height,Layout layout )
+	{
+		return layout == Layout::Tiled ? (height + blockSize - 1) / blockSize * blockSize : height;
+	}
+	size_t Index( unsigned int x,unsigned int y ) const
+	{
+		if( layout == Layout::Linear )
+		{
+			return size_t( y ) * pitch + x;
+		}
+		// row of blocks, block in the row, row in the block, pixel in the row
+		constexpr unsigned int m = blockSize - 1;
+		return size_t( y & ~m ) * pitch + (x & ~m) * blockSize + (y & m) * blockSize + (x & m);
+	}
+	// calls f( pRun,x,n ) for the runs [x,x + n) of the pixels [xStart,xEnd) of row y that are
+	// contiguous in memory: the whole span when linear, up to blockSize pixels when tiled
+	template<class F>
+	void ForEachRun( unsigned int xStart,unsigned int xEnd,unsigned int y,F&& f ) const
+	{
+		if( layout == Layout::Linear )
+		{
+			f( &pBuffer[size_t( y ) * pitch + xStart],xStart,xEnd - xStart );
+			return;
+		}
+		while( xStart < xEnd )
+		{
+			const unsigned int runEnd = std::min( xEnd,(xStart | (blockSize - 1)) + 1 );
+			f( &pBuffer[Index( xStart,y )],xStart,runEnd - xStart );
+			xStart = runEnd;
+		}
+	}
+	// writes the pixels of pDst[0..count) whose mask bit is set from pColors
+	static void StoreMasked( Color* pDst,const Color* pColors,unsigned int mask,unsigned int count )
+	{
+		const __m128i laneBits = _mm_setr_epi32( 1,2,4,8 );
+		unsigned int i = 0;
+		for( ; i + 4 <= count; i += 4 )
+		{
+			const unsigned int m = (mask >> i) & 0xFu;
+			if( m == 0xFu )
+			{
+				_mm_storeu_si128( reinterpret_cast<__m128i*>(pDst + i),
+					_mm_loadu_si128( reinterpret_cast<const __m128i*>(pColors + i) ) );
+			}
+			else if( m != 0u )
+			{
+				// expand 4 mask bits to 4 lane masks and merge with what is already there
+				const __m128i laneMask = _mm_cmpeq_epi32(
+					_mm_and_si128( _mm_set1_epi32( int( m ) ),laneBits ),laneBits );
+				const __m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pColors + i) );
+				const __m128i dst = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pDst + i) );
+				_mm_storeu_si128( reinterpret_cast<__m128i*>(pDst + i),
+					_mm_or_si128( _mm_and_si128( laneMask,src ),_mm_andnot_si128( laneMask,dst ) ) );
+			}
+		}
+		for( ; i < count; i++ )
+		{
+			if( mask & (1u << i) )
+			{
+				pDst[i] = pColors[i];
+			}
+		}
+	}
+	// n pixels from pSrc to pDst, 4 per store
+	static void CopyPixels( Color* pDst,const Color* pSrc,int n )
+	{
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 )
+		{
+			_mm_storeu_si128( reinterpret_cast<__m128i*>(pDst + i),
+				_mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc + i) ) );
+		}
+		for( ; i < n; i++ )
+		{
+			pDst[i] = pSrc[i];
+		}
+	}
+	// n pixels of c, 4 per (aligned) store
+	static void FillPixels( Color* pDst,size_t n,Color c )
+	{
+		Color* const pEnd = pDst + n;
+		// scalar head until 16-byte aligned
+		for( ; pDst < pEnd && (reinterpret_cast<uintptr_t>(pDst) & 15u) != 0u; pDst++ )
+		{
+			*pDst = c;
+		}
+		const __m128i fill = _mm_set1_epi32( int( c.dword ) );
+		for( ; pEnd - pDst >= 4; pDst += 4 )
+		{
+			_mm_store_si128( reinterpret_cast<__m128i*>(pDst),fill );
+		}
+		for( ; pDst < pEnd; pDst++ )
+		{
+			*pDst = c;
+		}
+	}
+	// n pixels blended with c, see Blend
+	static void BlendPixels( Color* pDst,size_t n,Color c )
+	{
+		const unsigned int a = c.GetA();
+		const unsigned int ia = 255u - a;
+		// 2 pixels per register with a 16-bit lane per channel (b,g,r,x in memory order):
+		// c's channels times alpha, and the destination weight, both 0 for x
+		const __m128i src = _mm_setr_epi16(
+			short( c.GetB() * a ),short( c.GetG() * a ),short( c.GetR() * a ),0,
+			short( c.GetB() * a ),short( c.GetG() * a ),short( c.GetR() * a ),0 );
+		const __m128i weight = _mm_setr_epi16( short( ia ),short( ia ),short( ia ),0,short( ia ),short( ia ),short( ia ),0 );
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+		for( ; i + 4 <= n; i += 4 )
+		{
+			// sums stay below 256 * 255, so the 16-bit adds don't overflow (unsigned)
+			const __m128i d = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pDst + i) );
+			const __m128i lo = _mm_srli_epi16( _mm_add_epi16( src,_mm_mullo_epi16( _mm_unpacklo_epi8( d,zero ),weight ) ),8 );
+			const __m128i hi = _mm_srli_epi16( _mm_add_epi16( src,_mm_mullo_epi16( _mm_unpackhi_epi8( d,zero ),weight ) ),8 );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>(pDst + i),_mm_packus_epi16( lo,hi ) );
+		}
+		for( ; i < n; i++ )
+		{
+			pDst[i] = Blend( c,pDst[i] );
+		}
+	}
+	// CopyPixels with non-temporal stores, for destinations that won't be read again soon
+	// (only worth it there: streaming a frame that gets drawn on next evicts it from the cache)
+	// the stores need 16-byte aligned destinations, so the head is copied scalar until aligned
+	// callers issue the _mm_sfence once they are done
+	static void StreamCopy( Color* pDst,const Color* pSrc,unsigned int n )
+	{
+		Color* const pEnd = pDst + n;
+		for( ; pDst < pEnd && (reinterpret_cast<uintptr_t>(pDst) & 15u) != 0u; pDst++,pSrc++ )
+		{
+			*pDst = *pSrc;
+		}
+		for( ; pEnd - pDst >= 4; pDst += 4,pSrc += 4 )
+		{
+			_mm_stream_si128( reinterpret_cast<__m128i*>(pDst),
+				_mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) ) );
+		}
+		for( ; pDst < pEnd; pDst++,pSrc++ )
+		{
+			*pDst = *pSrc;
+		}
+	}
 	// calculate pixel pitch required for given byte aligment (must be multiple of 4 bytes)
 	static unsigned int GetPitch( unsigned int width,unsigned int byteAlignment )
 	{
@@ -129,16 +479,23 @@ private:
 		const unsigned int pixelAlignment = byteAlignment / sizeof( Color );
 		return width + ( pixelAlignment - width % pixelAlignment ) % pixelAlignment;
 	}
-	Surface( unsigned int width,unsigned int height,unsigned int pitch,std::unique_ptr<Color[]> pBufferParam )
+	Surface( unsigned int width,unsigned int height,unsigned int pitch,Layout layout )
 		:
+		pStorage( Allocate( size_t( pitch ) * GetPaddedHeight( height,layout ) ) ),
+		pBuffer( reinterpret_cast<Color*>(pStorage.get()) ),
 		width( width ),
 		height( height ),
-		pBuffer( std::move( pBufferParam ) ),
-		pitch( pitch )
-	{}
+		pitch( pitch ),
+		layout( layout )
+	{
+		assert( pitch >= width );
+	}
 private:
-	std::unique_ptr<Color[]> pBuffer;
+	// null for surfaces made from a view
+	std::unique_ptr<CacheLine[]> pStorage;
+	Color* pBuffer;
 	unsigned int width;
 	unsigned int height;
 	unsigned int pitch; // pitch is in PIXELS, not bytes!
+	Layout layout;
 };
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Colors.h"
+#include <assert.h>
+
+// linear pixels in memory that belongs to somebody else (a mapped texture, a mapped file,
+// shared memory), rows pitch PIXELS apart
+// a Surface made from a view draws straight into that memory (see Surface( const SurfaceView& )),
+// the memory has to outlive it
+class SurfaceView
+{
+public:
+	SurfaceView() = default;
+	SurfaceView( Color* pPixels,unsigned int width,unsigned int height,unsigned int pitch )
+		:
+		pPixels( pPixels ),
+		width( width ),
+		height( height ),
+		pitch( pitch )
+	{
+		assert( pitch >= width );
+	}
+	// from a byte pitch, as mapping APIs report it (has to be a whole number of pixels)
+	static SurfaceView FromBytePitch( void* pData,unsigned int width,unsigned int height,unsigned int bytePitch )
+	{
+		assert( bytePitch % sizeof( Color ) == 0 );
+		return{ static_cast<Color*>(pData),width,height,(unsigned int)(bytePitch / sizeof( Color )) };
+	}
+public:
+	Color* pPixels = nullptr;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int pitch = 0;
+};
\ No newline at end of file
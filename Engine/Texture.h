@@ -0,0 +1,215 @@
+#pragma once
+
+#include "Surface.h"
+#include "SimdBlock.h"
+#include "Vec3.h"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+// read-only mipmapped texture for sampling in pixel shaders
+// every mip level is stored in tileDim x tileDim texel tiles (64 bytes, one cache line each)
+// so the 2x2 footprint of a bilinear fetch mostly lands in a single line whatever the direction
+// sampling is bilinear within one mip level, addressing is clamp to edge
+// channels are returned as floats in 0-255
+class Texture
+{
+public:
+	static constexpr int tileDim = 4;
+public:
+	Texture( const Surface& src )
+	{
+		// level 0 straight from the surface, then 2x2 box filter down to 1x1
+		int width = int( src.GetWidth() );
+		int height = int( src.GetHeight() );
+		std::vector<Color> linear( width * height );
+		for( int y = 0; y < height; y++ )
+		{
+			for( int x = 0; x < width; x++ )
+			{
+				linear[y * width + x] = src.GetPixel( x,y );
+			}
+		}
+		while( true )
+		{
+			AddLevel( linear,width,height );
+			if( width == 1 && height == 1 )
+			{
+				break;
+			}
+			const int nextWidth = std::max( width / 2,1 );
+			const int nextHeight = std::max( height / 2,1 );
+			std::vector<Color> next( nextWidth * nextHeight );
+			for( int y = 0; y < nextHeight; y++ )
+			{
+				const int y0 = std::min( y * 2,height - 1 );
+				const int y1 = std::min( y * 2 + 1,height - 1 );
+				for( int x = 0; x < nextWidth; x++ )
+				{
+					const int x0 = std::min( x * 2,width - 1 );
+					const int x1 = std::min( x * 2 + 1,width - 1 );
+					const Color c[4] = {
+						linear[y0 * width + x0],linear[y0 * width + x1],
+						linear[y1 * width + x0],linear[y1 * width + x1] };
+					const auto average = [&c]( unsigned int shift )
+					{
+						unsigned int sum = 2u;
+						for( const Color& t : c )
+						{
+							sum += (t.dword >> shift) & 0xFFu;
+						}
+						return (sum / 4u) << shift;
+					};
+					next[y * nextWidth + x] = average( 16u ) | average( 8u ) | average( 0u );
+				}
+			}
+			linear = std::move( next );
+			width = nextWidth;
+			height = nextHeight;
+		}
+	}
+	static Texture FromFile( const std::wstring& name )
+	{
+		return Texture( Surface::FromFile( name ) );
+	}
+	int GetWidth() const
+	{
+		return levels.front().width;
+	}
+	int GetHeight() const
+	{
+		return levels.front().height;
+	}
+	int GetLevelCount() const
+	{
+		return int( levels.size() );
+	}
+	// mip level to sample when one pixel spans texelsPerPixel texels of level 0
+	// (the nearest one: level n is used from 2^(n - 0.5) up to 2^(n + 0.5) texels per pixel)
+	int GetMipLevel( float texelsPerPixel ) const
+	{
+		if( !(texelsPerPixel > 1.0f) )
+		{
+			return 0;
+		}
+		return std::min( int( std::log2( texelsPerPixel ) + 0.5f ),GetLevelCount() - 1 );
+	}
+	// bilinear sample of a single point, rgb channels 0-255
+	Vec3 Sample( float u,float v,int level ) const
+	{
+		const Level& l = levels[level];
+		const float x = u * float( l.width ) - 0.5f;
+		const float y = v * float( l.height ) - 0.5f;
+		const float x0f = std::floor( x );
+		const float y0f = std::floor( y );
+		const float fx = x - x0f;
+		const float fy = y - y0f;
+		const int x0 = std::clamp( int( x0f ),0,l.width - 1 );
+		const int x1 = std::clamp( int( x0f ) + 1,0,l.width - 1 );
+		const int y0 = std::clamp( int( y0f ),0,l.height - 1 );
+		const int y1 = std::clamp( int( y0f ) + 1,0,l.height - 1 );
+		const unsigned int* pLevel = &texels[l.offset];
+		const unsigned int t00 = pLevel[TexelIndex( l,x0,y0 )];
+		const unsigned int t10 = pLevel[TexelIndex( l,x1,y0 )];
+		const unsigned int t01 = pLevel[TexelIndex( l,x0,y1 )];
+		const unsigned int t11 = pLevel[TexelIndex( l,x1,y1 )];
+		const auto filter = [=]( unsigned int shift )
+		{
+			const float c00 = float( (t00 >> shift) & 0xFFu );
+			const float c10 = float( (t10 >> shift) & 0xFFu );
+			const float c01 = float( (t01 >> shift) & 0xFFu );
+			const float c11 = float( (t11 >> shift) & 0xFFu );
+			const float top = c00 + (c10 - c00) * fx;
+			const float bottom = c01 + (c11 - c01) * fx;
+			return top + (bottom - top) * fy;
+		};
+		return{ filter( 16u ),filter( 8u ),filter( 0u ) };
+	}
+	// bilinear sample of FloatBlock::width points at once, same math as the single point version
+	// texel addresses are computed in float (exact for any sane texture size) and fetched with gathers
+	void Sample( const FloatBlock& u,const FloatBlock& v,int level,FloatBlock& r,FloatBlock& g,FloatBlock& b ) const
+	{
+		const Level& l = levels[level];
+		const FloatBlock half = FloatBlock::Broadcast( 0.5f );
+		const FloatBlock one = FloatBlock::Broadcast( 1.0f );
+		const FloatBlock x = u * FloatBlock::Broadcast( float( l.width ) ) - half;
+		const FloatBlock y = v * FloatBlock::Broadcast( float( l.height ) ) - half;
+		const FloatBlock x0f = x.Floor();
+		const FloatBlock y0f = y.Floor();
+		const FloatBlock fx = x - x0f;
+		const FloatBlock fy = y - y0f;
+		const float xMax = float( l.width - 1 );
+		const float yMax = float( l.height - 1 );
+		const FloatBlock offX0 = TiledOffsetX( x0f.Clamp( 0.0f,xMax ) );
+		const FloatBlock offX1 = TiledOffsetX( (x0f + one).Clamp( 0.0f,xMax ) );
+		const FloatBlock offY0 = TiledOffsetY( l,y0f.Clamp( 0.0f,yMax ) );
+		const FloatBlock offY1 = TiledOffsetY( l,(y0f + one).Clamp( 0.0f,yMax ) );
+		const unsigned int* pLevel = &texels[l.offset];
+		const IntBlock t00 = IntBlock::Gather( pLevel,IntBlock::FromFloat( offX0 + offY0 ) );
+		const IntBlock t10 = IntBlock::Gather( pLevel,IntBlock::FromFloat( offX1 + offY0 ) );
+		const IntBlock t01 = IntBlock::Gather( pLevel,IntBlock::FromFloat( offX0 + offY1 ) );
+		const IntBlock t11 = IntBlock::Gather( pLevel,IntBlock::FromFloat( offX1 + offY1 ) );
+		const auto filter = [&]( int shift )
+		{
+			const FloatBlock c00 = t00.Channel( shift );
+			const FloatBlock c01 = t01.Channel( shift );
+			const FloatBlock top = c00 + (t10.Channel( shift ) - c00) * fx;
+			const FloatBlock bottom = c01 + (t11.Channel( shift ) - c01) * fx;
+			return top + (bottom - top) * fy;
+		};
+		r = filter( 16 );
+		g = filter( 8 );
+		b = filter( 0 );
+	}
+private:
+	class Level
+	{
+	public:
+		int width;
+		int height;
+		int tilesPerRow;
+		// index of the level's first texel in texels
+		size_t offset;
+	};
+private:
+	void AddLevel( const std::vector<Color>& linear,int width,int height )
+	{
+		Level l;
+		l.width = width;
+		l.height = height;
+		l.tilesPerRow = (width + tileDim - 1) / tileDim;
+		l.offset = texels.size();
+		const int tileRows = (height + tileDim - 1) / tileDim;
+		texels.resize( texels.size() + size_t( l.tilesPerRow ) * tileRows * tileDim * tileDim,0u );
+		for( int y = 0; y < height; y++ )
+		{
+			for( int x = 0; x < width; x++ )
+			{
+				texels[l.offset + TexelIndex( l,x,y )] = linear[y * width + x].dword;
+			}
+		}
+		levels.push_back( l );
+	}
+	static size_t TexelIndex( const Level& l,int x,int y )
+	{
+		const int tileIndex = (y / tileDim) * l.tilesPerRow + x / tileDim;
+		return size_t( tileIndex ) * tileDim * tileDim + (y % tileDim) * tileDim + x % tileDim;
+	}
+	// TexelIndex split into a part that depends only on x and one only on y:
+	//   x part: (x / 4) * 16 + x % 4 = x + 12 * floor( x / 4 )
+	//   y part: (y / 4) * tilesPerRow * 16 + (y % 4) * 4 = 4 * y + (tilesPerRow * 16 - 16) * floor( y / 4 )
+	static FloatBlock TiledOffsetX( const FloatBlock& x )
+	{
+		return x + (x * FloatBlock::Broadcast( 1.0f / float( tileDim ) )).Floor() *
+			FloatBlock::Broadcast( float( tileDim * tileDim - tileDim ) );
+	}
+	static FloatBlock TiledOffsetY( const Level& l,const FloatBlock& y )
+	{
+		return y * FloatBlock::Broadcast( float( tileDim ) ) + (y * FloatBlock::Broadcast( 1.0f / float( tileDim ) )).Floor() *
+			FloatBlock::Broadcast( float( (l.tilesPerRow - 1) * tileDim * tileDim ) );
+	}
+private:
+	std::vector<Level> levels;
+	std::vector<unsigned int> texels;
+};
\ No newline at end of file
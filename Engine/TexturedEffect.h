@@ -0,0 +1,202 @@
+#pragma once
+
+#include "Pipeline.h"
+#include "DefaultGeometryShader.h"
+#include "SimdBlock.h"
+#include "Texture.h"
+#include "Mat2.h"
+#include "Affine2.h"
+#include "Camera.h"
+#include "ChiliMath.h"
+
+// texture coordinates given per vertex and interpolated across the triangle,
+// texture sampled (mipmapped bilinear) and modulated by a tint color
+// pixel shader supports batch shading (see HasBatchShading)
+class TexturedEffect
+{
+public:
+	// 2D only, pipeline takes the affine path (see IsAffine2D)
+	static constexpr bool isAffine2D = true;
+	// the vertex type that will be input into the pipeline
+	class Vertex
+	{
+	public:
+		Vec2 pos;
+		Vec2 uv;
+	};
+	// rotates and translates vertices, passes uv through
+	class VertexShader
+	{
+	public:
+		class Output
+		{
+		public:
+			Output() = default;
+			Output( const Vec3& pos,const Vec2& uv )
+				:
+				pos( pos ),
+				uv( uv )
+			{}
+			Output& operator+=( const Output& rhs )
+			{
+				pos += rhs.pos;
+				uv += rhs.uv;
+				return *this;
+			}
+			Output operator+( const Output& rhs ) const
+			{
+				return Output( *this ) += rhs;
+			}
+			Output& operator-=( const Output& rhs )
+			{
+				pos -= rhs.pos;
+				uv -= rhs.uv;
+				return *this;
+			}
+			Output operator-( const Output& rhs ) const
+			{
+				return Output( *this ) -= rhs;
+			}
+			Output& operator*=( float rhs )
+			{
+				pos *= rhs;
+				uv *= rhs;
+				return *this;
+			}
+			Output operator*( float rhs ) const
+			{
+				return Output( *this ) *= rhs;
+			}
+			Output& operator/=( float rhs )
+			{
+				pos /= rhs;
+				uv /= rhs;
+				return *this;
+			}
+			Output operator/( float rhs ) const
+			{
+				return Output( *this ) /= rhs;
+			}
+		public:
+			Vec3 pos;
+			Vec2 uv;
+		};
+		Camera cam;
+	public:
+		void BindRotation( const Mat2& rotation_in )
+		{
+			rotation = rotation_in;
+		}
+		void BindTranslation( const Vec2& translation_in )
+		{
+			translation = translation_in;
+		}
+		// layer depth written to z (smaller is closer when depth testing)
+		void BindDepth( float depth_in )
+		{
+			depth = depth_in;
+		}
+		Output operator()( const Vertex& in ) const
+		{
+			const Vec2 xformd = (in.pos * rotation + translation + cam.GetTranslation()) * cam.GetZoom();
+			return{ { xformd.x,xformd.y,depth },in.uv };
+		}
+		// model to normalized device space, for the pipeline's 2D affine path
+		Affine2 GetTransform() const
+		{
+			return{ rotation * cam.GetZoom(),(translation + cam.GetTranslation()) * cam.GetZoom() };
+		}
+		Output operator()( const Vertex& in,const Affine2& modelToScreen ) const
+		{
+			const Vec2 xformd = in.pos * modelToScreen;
+			return{ { xformd.x,xformd.y,depth },in.uv };
+		}
+	private:
+		Mat2 rotation;
+		Vec2 translation;
+		float depth = 1.0f;
+	};
+	// default gs passes vertices through and outputs triangle
+	typedef DefaultGeometryShader<VertexShader::Output> GeometryShader;
+	// samples the bound texture at the interpolated uv and multiplies by the tint
+	class PixelShader
+	{
+	public:
+		// u,v
+		static constexpr int nAttributes = 2;
+	public:
+		void BindTexture( const Texture& texture )
+		{
+			pTexture = &texture;
+		}
+		void BindMipLevel( int level_in )
+		{
+			level = level_in;
+		}
+		void BindTint( Color c )
+		{
+			tint = Vec3( float( c.GetR() ),float( c.GetG() ),float( c.GetB() ) ) / 255.0f;
+		}
+		template<class I>
+		static void LoadAttributes( const I& in,float* pAttributes )
+		{
+			pAttributes[0] = in.uv.x;
+			pAttributes[1] = in.uv.y;
+		}
+		template<class I>
+		Color operator()( const I& in ) const
+		{
+			const Vec3 c = pTexture->Sample( in.uv.x,in.uv.y,level );
+			return Color( Vec3( c.x * tint.x,c.y * tint.y,c.z * tint.z ) );
+		}
+		void operator()( const FloatBlock* pAttributes,Color* pOut ) const
+		{
+			FloatBlock r;
+			FloatBlock g;
+			FloatBlock b;
+			pTexture->Sample( pAttributes[0],pAttributes[1],level,r,g,b );
+			StoreColors(
+				r * FloatBlock::Broadcast( tint.x ),
+				g * FloatBlock::Broadcast( tint.y ),
+				b * FloatBlock::Broadcast( tint.z ),
+				pOut );
+		}
+	private:
+		const Texture* pTexture = nullptr;
+		int level = 0;
+		Vec3 tint = { 1.0f,1.0f,1.0f };
+	};
+	// per-instance state for instanced draws
+	class Instance
+	{
+	public:
+		Mat2 rotation;
+		Vec2 translation;
+		// radius of a circle around translation that contains the whole transformed model
+		float boundingRadius;
+		const Texture* pTexture;
+		Color tint;
+		// extent of the texture (uv 0-1) in model units, for picking the mip level
+		float uvSpan;
+	};
+public:
+	bool IsInstanceVisible( const Instance& inst ) const
+	{
+		return vs.cam.Overlaps( inst.translation,inst.boundingRadius );
+	}
+	void BindInstance( const Instance& inst )
+	{
+		vs.BindRotation( inst.rotation );
+		vs.BindTranslation( inst.translation );
+		ps.BindTexture( *inst.pTexture );
+		ps.BindTint( inst.tint );
+		// one model unit covers scale * zoom of normalized device space, which is half the screen
+		const float scale = std::sqrt( sq( inst.rotation.elements[0][0] ) + sq( inst.rotation.elements[0][1] ) );
+		const float pixelsAcross = inst.uvSpan * scale * vs.cam.GetZoom() * float( Graphics::ScreenWidth ) / 2.0f;
+		ps.BindMipLevel( inst.pTexture->GetMipLevel( float( inst.pTexture->GetWidth() ) / pixelsAcross ) );
+	}
+public:
+	VertexShader vs;
+	GeometryShader gs;
+	PixelShader ps;
+};
\ No newline at end of file
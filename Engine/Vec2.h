@@ -21,7 +21,7 @@
 #pragma once
 
 #include "ChiliMath.h"
-#include <Box2D\Box2D.h>
+#include <Box2D/Box2D.h>
 
 template <typename T>
 class _Vec2
@@ -34,10 +34,7 @@ public:
 		x( x ),
 		y( y )
 	{}
-	_Vec2( const _Vec2& vect )
-		:
-		_Vec2( vect.x,vect.y )
-	{}
+	_Vec2( const _Vec2& vect ) = default;
 	template <typename T2>
 	explicit operator _Vec2<T2>() const
 	{
@@ -76,12 +73,7 @@ public:
 	{
 		return _Vec2( -x,-y );
 	}
-	_Vec2&	operator=( const _Vec2 &rhs )
-	{
-		x = rhs.x;
-		y = rhs.y;
-		return *this;
-	}
+	_Vec2&	operator=( const _Vec2 &rhs ) = default;
 	_Vec2&	operator+=( const _Vec2 &rhs )
 	{
 		x += rhs.x;
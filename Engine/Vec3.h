@@ -26,17 +26,18 @@
 template <typename T>
 class _Vec3 : public _Vec2<T>
 {
+public:
+	// members of a dependent base aren't found unqualified outside msvc
+	using _Vec2<T>::x;
+	using _Vec2<T>::y;
 public:
 	_Vec3() {}
 	_Vec3( T x,T y,T z )
 		:
-		_Vec2( x,y ),
+		_Vec2<T>( x,y ),
 		z( z )
 	{}
-	_Vec3( const _Vec3& vect )
-		:
-		_Vec3( vect.x,vect.y,vect.z )
-	{}
+	_Vec3( const _Vec3& vect ) = default;
 	template <typename T2>
 	explicit operator _Vec3<T2>() const
 	{
@@ -73,13 +74,7 @@ public:
 	{
 		return _Vec3( -x,-y,-z );
 	}
-	_Vec3&	operator=( const _Vec3 &rhs )
-	{
-		x = rhs.x;
-		y = rhs.y;
-		z = rhs.z;
-		return *this;
-	}
+	_Vec3&	operator=( const _Vec3 &rhs ) = default;
 	_Vec3&	operator+=( const _Vec3 &rhs )
 	{
 		x += rhs.x;
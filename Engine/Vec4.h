@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Vec3.h"
+
+// homogeneous coordinates (clip space positions for the perspective pipeline)
+// arithmetic covers w as well, so w (or 1/w after the divide) interpolates along with x,y,z
+template <typename T>
+class _Vec4 : public _Vec3<T>
+{
+public:
+	using _Vec2<T>::x;
+	using _Vec2<T>::y;
+	using _Vec3<T>::z;
+public:
+	_Vec4() {}
+	_Vec4( T x,T y,T z,T w )
+		:
+		_Vec3<T>( x,y,z ),
+		w( w )
+	{}
+	explicit _Vec4( const _Vec3<T>& v3,T w = (T)1.0 )
+		:
+		_Vec3<T>( v3 ),
+		w( w )
+	{}
+	_Vec4	operator-() const
+	{
+		return _Vec4( -x,-y,-z,-w );
+	}
+	_Vec4&	operator+=( const _Vec4& rhs )
+	{
+		x += rhs.x;
+		y += rhs.y;
+		z += rhs.z;
+		w += rhs.w;
+		return *this;
+	}
+	_Vec4&	operator-=( const _Vec4& rhs )
+	{
+		x -= rhs.x;
+		y -= rhs.y;
+		z -= rhs.z;
+		w -= rhs.w;
+		return *this;
+	}
+	_Vec4	operator+( const _Vec4& rhs ) const
+	{
+		return _Vec4( *this ) += rhs;
+	}
+	_Vec4	operator-( const _Vec4& rhs ) const
+	{
+		return _Vec4( *this ) -= rhs;
+	}
+	_Vec4&	operator*=( const T& rhs )
+	{
+		x *= rhs;
+		y *= rhs;
+		z *= rhs;
+		w *= rhs;
+		return *this;
+	}
+	_Vec4	operator*( const T& rhs ) const
+	{
+		return _Vec4( *this ) *= rhs;
+	}
+	_Vec4&	operator/=( const T& rhs )
+	{
+		x /= rhs;
+		y /= rhs;
+		z /= rhs;
+		w /= rhs;
+		return *this;
+	}
+	_Vec4	operator/( const T& rhs ) const
+	{
+		return _Vec4( *this ) /= rhs;
+	}
+public:
+	T w;
+};
+
+typedef _Vec4<float> Vec4;
+typedef _Vec4<double> Ved4;
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "SimdBlock.h"
+#include "Vec3.h"
+#include "Vec4.h"
+#include "Mat4.h"
+#include <algorithm>
+
+// structure of arrays blocks of FloatBlock::width points, for batched vertex shaders (see HasBatchVertexShading)
+// loaded from and stored to the position members of arrays of vertices, stride is the vertex size in bytes
+// count is the number of points in a block (less than width for the last block of an array)
+
+class PointBlock4
+{
+public:
+	void Store( Vec4* pFirst,size_t stride,int count ) const
+	{
+		x.StoreStrided( &pFirst->x,stride,count );
+		y.StoreStrided( &pFirst->y,stride,count );
+		z.StoreStrided( &pFirst->z,stride,count );
+		w.StoreStrided( &pFirst->w,stride,count );
+	}
+public:
+	FloatBlock x;
+	FloatBlock y;
+	FloatBlock z;
+	FloatBlock w;
+};
+
+class PointBlock3
+{
+public:
+	static PointBlock3 Load( const Vec3* pFirst,size_t stride,int count )
+	{
+		return{
+			FloatBlock::LoadStrided( &pFirst->x,stride,count ),
+			FloatBlock::LoadStrided( &pFirst->y,stride,count ),
+			FloatBlock::LoadStrided( &pFirst->z,stride,count ) };
+	}
+	void Store( Vec3* pFirst,size_t stride,int count ) const
+	{
+		x.StoreStrided( &pFirst->x,stride,count );
+		y.StoreStrided( &pFirst->y,stride,count );
+		z.StoreStrided( &pFirst->z,stride,count );
+	}
+	// the points as ( x,y,z,1 ) times rhs
+	PointBlock4 operator*( const Mat4& rhs ) const
+	{
+		return{ Column( rhs,0 ),Column( rhs,1 ),Column( rhs,2 ),Column( rhs,3 ) };
+	}
+	// x,y,z of the points times rhs, for transforms that leave w at 1 (no projection)
+	PointBlock3 TransformAffine( const Mat4& rhs ) const
+	{
+		return{ Column( rhs,0 ),Column( rhs,1 ),Column( rhs,2 ) };
+	}
+private:
+	FloatBlock Column( const Mat4& m,int c ) const
+	{
+		return x * FloatBlock::Broadcast( m.elements[0][c] ) +
+			y * FloatBlock::Broadcast( m.elements[1][c] ) +
+			z * FloatBlock::Broadcast( m.elements[2][c] ) +
+			FloatBlock::Broadcast( m.elements[3][c] );
+	}
+public:
+	FloatBlock x;
+	FloatBlock y;
+	FloatBlock z;
+};
+
+// calls f( first,count ) for consecutive blocks of up to FloatBlock::width of n items
+template<class F>
+void ForEachBlock( size_t n,F&& f )
+{
+	for( size_t first = 0; first < n; first += FloatBlock::width )
+	{
+		f( first,int( std::min( n - first,size_t( FloatBlock::width ) ) ) );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <algorithm>
+
+// persistent pool of worker threads for fork/join style jobs
+// Run() hands out job indices [0,nJobs) to the workers and the calling thread,
+// and only returns after every job has completed
+// Runs from different threads take turns, a job must not Run on the pool it is running on
+class WorkerPool
+{
+public:
+	// the pool everybody shares (pipelines, loaders), started on first use
+	static WorkerPool& GetShared()
+	{
+		static WorkerPool shared;
+		return shared;
+	}
+	WorkerPool()
+		:
+		WorkerPool( std::max( std::thread::hardware_concurrency(),1u ) - 1u )
+	{}
+	WorkerPool( unsigned int nWorkers )
+	{
+		for( unsigned int i = 0; i < nWorkers; i++ )
+		{
+			workers.emplace_back( &WorkerPool::WorkerLoop,this );
+		}
+	}
+	WorkerPool( const WorkerPool& ) = delete;
+	WorkerPool& operator=( const WorkerPool& ) = delete;
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mtx );
+			dying = true;
+		}
+		cvStart.notify_all();
+		for( auto& w : workers )
+		{
+			w.join();
+		}
+	}
+	template<class F>
+	void Run( size_t nJobs,F&& func )
+	{
+		if( nJobs == 0 )
+		{
+			return;
+		}
+		// nothing to share, don't bother waking anybody up
+		if( workers.empty() || nJobs == 1 )
+		{
+			for( size_t i = 0; i < nJobs; i++ )
+			{
+				func( i );
+			}
+			return;
+		}
+		std::lock_guard<std::mutex> runLock( runMtx );
+		{
+			std::lock_guard<std::mutex> lock( mtx );
+			job = std::ref( func );
+			jobCount = nJobs;
+			nextJob = 0;
+			nActive = workers.size();
+			generation++;
+		}
+		cvStart.notify_all();
+		// calling thread pitches in too
+		DoJobs();
+		std::unique_lock<std::mutex> lock( mtx );
+		cvDone.wait( lock,[this]() { return nActive == 0; } );
+		job = nullptr;
+	}
+	size_t GetThreadCount() const
+	{
+		return workers.size() + 1;
+	}
+private:
+	void DoJobs()
+	{
+		for( size_t i = nextJob++; i < jobCount; i = nextJob++ )
+		{
+			job( i );
+		}
+	}
+	void WorkerLoop()
+	{
+		size_t lastGeneration = 0;
+		while( true )
+		{
+			{
+				std::unique_lock<std::mutex> lock( mtx );
+				cvStart.wait( lock,[this,lastGeneration]() { return dying || generation != lastGeneration; } );
+				if( dying )
+				{
+					return;
+				}
+				lastGeneration = generation;
+			}
+			DoJobs();
+			{
+				std::lock_guard<std::mutex> lock( mtx );
+				nActive--;
+			}
+			cvDone.notify_one();
+		}
+	}
+private:
+	std::vector<std::thread> workers;
+	std::mutex runMtx;
+	std::mutex mtx;
+	std::condition_variable cvStart;
+	std::condition_variable cvDone;
+	std::function<void( size_t )> job;
+	std::atomic<size_t> nextJob{ 0 };
+	size_t jobCount = 0;
+	size_t nActive = 0;
+	size_t generation = 0;
+	bool dying = false;
+};
\ No newline at end of file
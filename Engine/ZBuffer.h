@@ -0,0 +1,162 @@
+#pragma once
+
+#include "Rect.h"
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <assert.h>
+
+// per-pixel depth buffer (smaller depth is closer) with a coarse layer
+// of tileSize x tileSize tiles that tracks the depth range in each tile
+// so whole tiles/spans can be accepted or rejected without touching the pixels
+class ZBuffer
+{
+public:
+	static constexpr int tileSize = 8;
+public:
+	ZBuffer( int width,int height )
+		:
+		width( width ),
+		height( height ),
+		nTilesX( (width + tileSize - 1) / tileSize ),
+		nTilesY( (height + tileSize - 1) / tileSize ),
+		pBuffer( std::make_unique<float[]>( width * height ) ),
+		pTiles( std::make_unique<Tile[]>( nTilesX * nTilesY ) )
+	{
+		Clear();
+	}
+	ZBuffer( const ZBuffer& ) = delete;
+	ZBuffer& operator=( const ZBuffer& ) = delete;
+	void Clear()
+	{
+		const float depth = std::numeric_limits<float>::infinity();
+		std::fill( pBuffer.get(),pBuffer.get() + width * height,depth );
+		std::fill( pTiles.get(),pTiles.get() + nTilesX * nTilesY,Tile{ depth,depth,false } );
+	}
+	// early depth test, stores depth and returns true if it is closer than what is there
+	bool TestAndSet( int x,int y,float depth )
+	{
+		float& depthInBuffer = At( x,y );
+		if( depth < depthInBuffer )
+		{
+			depthInBuffer = depth;
+			UpdateTile( x,y,depth );
+			return true;
+		}
+		return false;
+	}
+	// stores depth without testing (for pixels already known to pass)
+	void Set( int x,int y,float depth )
+	{
+		At( x,y ) = depth;
+		UpdateTile( x,y,depth );
+	}
+	// true if depth can't pass anywhere in rect (it is behind the farthest depth of every tile touched)
+	// recomputes the exact farthest depth of tiles that have been written since last time
+	bool IsOccluded( const RectI& rect,float depth )
+	{
+		for( int ty = rect.top / tileSize,ty1 = (rect.bottom - 1) / tileSize; ty <= ty1; ty++ )
+		{
+			for( int tx = rect.left / tileSize,tx1 = (rect.right - 1) / tileSize; tx <= tx1; tx++ )
+			{
+				Tile& tile = pTiles[ty * nTilesX + tx];
+				if( depth < tile.zMax )
+				{
+					return false;
+				}
+				if( tile.dirty )
+				{
+					RefreshTile( tx,ty );
+					if( depth < tile.zMax )
+					{
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+	// span version of the occlusion test, uses the cached (conservative) tile depths as they are
+	bool IsSpanOccluded( int xStart,int xEnd,int y,float depth ) const
+	{
+		const Tile* pRow = &pTiles[(y / tileSize) * nTilesX];
+		for( int tx = xStart / tileSize,tx1 = (xEnd - 1) / tileSize; tx <= tx1; tx++ )
+		{
+			if( depth < pRow[tx].zMax )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	// true if depth passes everywhere in span (it is in front of the closest depth of every tile touched)
+	bool IsSpanUnoccluded( int xStart,int xEnd,int y,float depth ) const
+	{
+		const Tile* pRow = &pTiles[(y / tileSize) * nTilesX];
+		for( int tx = xStart / tileSize,tx1 = (xEnd - 1) / tileSize; tx <= tx1; tx++ )
+		{
+			if( depth >= pRow[tx].zMin )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	float& At( int x,int y )
+	{
+		assert( x >= 0 );
+		assert( x < width );
+		assert( y >= 0 );
+		assert( y < height );
+		return pBuffer[y * width + x];
+	}
+	const float& At( int x,int y ) const
+	{
+		return const_cast<ZBuffer*>(this)->At( x,y );
+	}
+	int GetWidth() const
+	{
+		return width;
+	}
+	int GetHeight() const
+	{
+		return height;
+	}
+private:
+	// zMin is exact, zMax is an upper bound that is only tightened when dirty tiles are refreshed
+	struct Tile
+	{
+		float zMin;
+		float zMax;
+		bool dirty;
+	};
+private:
+	void UpdateTile( int x,int y,float depth )
+	{
+		Tile& tile = pTiles[(y / tileSize) * nTilesX + x / tileSize];
+		tile.zMin = std::min( tile.zMin,depth );
+		tile.dirty = true;
+	}
+	void RefreshTile( int tx,int ty )
+	{
+		Tile& tile = pTiles[ty * nTilesX + tx];
+		float zMax = -std::numeric_limits<float>::infinity();
+		for( int y = ty * tileSize,yEnd = std::min( y + tileSize,height ); y < yEnd; y++ )
+		{
+			const float* pRow = &pBuffer[y * width];
+			for( int x = tx * tileSize,xEnd = std::min( x + tileSize,width ); x < xEnd; x++ )
+			{
+				zMax = std::max( zMax,pRow[x] );
+			}
+		}
+		tile.zMax = zMax;
+		tile.dirty = false;
+	}
+private:
+	int width;
+	int height;
+	int nTilesX;
+	int nTilesY;
+	std::unique_ptr<float[]> pBuffer;
+	std::unique_ptr<Tile[]> pTiles;
+};
\ No newline at end of file